@@ -0,0 +1,189 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+// Self contained benchmark harness: measures save/load throughput, bytes per object, heap allocations
+// and base64/print throughput for a few workloads and data set sizes.
+// usage: tser_bench [object counts...] (default: 10 1000 100000)
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <tser/tser.hpp>
+#include "monsters.hpp"
+
+//counts every heap allocation of the process, so we can report allocations per operation
+//the replacements are a malloc/free pair, which gcc can't see through and reports as mismatched
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+static size_t g_allocations = 0;
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+//additional workloads that stress one kind of member
+namespace workloads
+{
+    using namespace cpp_serializers_benchmark;
+
+    struct IntegerRecord {
+        DEFINE_SERIALIZABLE(IntegerRecord,id,timestamp,counts,flags)
+        uint64_t id;
+        int64_t timestamp;
+        std::vector<int32_t> counts;
+        uint32_t flags;
+    };
+
+    struct StringRecord {
+        DEFINE_SERIALIZABLE(StringRecord,key,tags,message)
+        std::string key;
+        std::vector<std::string> tags;
+        std::string message;
+    };
+
+    struct FloatRecord {
+        DEFINE_SERIALIZABLE(FloatRecord,origin,path,values)
+        Vec3 origin;
+        std::vector<Vec3> path;
+        std::vector<double> values;
+    };
+
+    static std::string randomString(engine& e, int length) {
+        std::string res;
+        std::generate_n(std::back_inserter(res), length, std::bind(rand_char, std::ref(e)));
+        return res;
+    }
+
+    template<typename T>
+    std::vector<T> create(size_t count);
+
+    template<>
+    std::vector<Monster> create<Monster>(size_t count) {
+        return createMonsters(count);
+    }
+
+    template<>
+    std::vector<IntegerRecord> create<IntegerRecord>(size_t count) {
+        std::seed_seq seed{ 1,2,3 };
+        engine e{ seed };
+        std::uniform_int_distribution<int32_t> smallInts(-1000, 100000);
+        std::vector<IntegerRecord> res(count);
+        for (size_t i = 0; i < count; ++i) {
+            res[i].id = i * 7919u;
+            res[i].timestamp = 1600000000000 + static_cast<int64_t>(i) * 17;
+            res[i].flags = static_cast<uint32_t>(e());
+            std::generate_n(std::back_inserter(res[i].counts), rand_len(e) * 4, [&]() { return smallInts(e); });
+        }
+        return res;
+    }
+
+    template<>
+    std::vector<StringRecord> create<StringRecord>(size_t count) {
+        std::seed_seq seed{ 1,2,3 };
+        engine e{ seed };
+        std::vector<StringRecord> res(count);
+        for (auto& r : res) {
+            r.key = randomString(e, 16);
+            std::generate_n(std::back_inserter(r.tags), rand_len(e), [&]() { return randomString(e, rand_len(e)); });
+            r.message = randomString(e, rand_len(e) * 20);
+        }
+        return res;
+    }
+
+    template<>
+    std::vector<FloatRecord> create<FloatRecord>(size_t count) {
+        std::seed_seq seed{ 1,2,3 };
+        engine e{ seed };
+        std::uniform_real_distribution<double> randDouble(-1000.0, 1000.0);
+        std::vector<FloatRecord> res(count);
+        for (auto& r : res) {
+            r.origin = Vec3{ rand_float(e), rand_float(e), rand_float(e) };
+            std::generate_n(std::back_inserter(r.path), rand_len(e) * 2, [&]() { return Vec3{ rand_float(e), rand_float(e), rand_float(e) }; });
+            std::generate_n(std::back_inserter(r.values), rand_len(e) * 4, [&]() { return randDouble(e); });
+        }
+        return res;
+    }
+}
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    struct Measurement {
+        double secondsPerIteration = 0;
+        double allocationsPerIteration = 0;
+    };
+
+    //repeats f until at least minTime passed (and at least 3 times), reports the fastest iteration
+    template<typename F>
+    Measurement measure(F&& f, std::chrono::duration<double> minTime = std::chrono::milliseconds(200)) {
+        Measurement m{ 1e300, 0 };
+        size_t iterations = 0, allocations = 0;
+        const auto start = clock_type::now();
+        while (iterations < 3 || clock_type::now() - start < minTime) {
+            const size_t allocationsBefore = g_allocations;
+            const auto t0 = clock_type::now();
+            f();
+            const auto t1 = clock_type::now();
+            allocations += g_allocations - allocationsBefore;
+            m.secondsPerIteration = std::min(m.secondsPerIteration, std::chrono::duration<double>(t1 - t0).count());
+            ++iterations;
+        }
+        m.allocationsPerIteration = static_cast<double>(allocations) / static_cast<double>(iterations);
+        return m;
+    }
+
+    //keeps the optimizer from removing the benchmarked work
+    volatile size_t g_sink = 0;
+
+    template<typename T>
+    void runWorkload(const char* name, size_t count) {
+        const auto objects = workloads::create<T>(count);
+        const double n = static_cast<double>(count);
+        tser::BinaryArchive ba;
+        auto save = measure([&]() { ba.reset(); ba.save(objects); g_sink = g_sink + ba.get_buffer().size(); });
+        const double bytes = static_cast<double>(ba.get_buffer().size());
+        auto load = measure([&]() { ba.set_read_offset(0); auto loaded = ba.load<std::vector<T>>(); g_sink = g_sink + loaded.size(); });
+        auto base64 = measure([&]() { g_sink = g_sink + tser::encode_base64(ba.get_buffer()).size(); });
+        std::ostringstream os;
+        auto print = measure([&]() { os.str(std::string()); for (auto& o : objects) tser::print(os, o); g_sink = g_sink + static_cast<size_t>(os.tellp()); });
+
+        auto mbs = [&](const Measurement& m, double b) { return b / m.secondsPerIteration / (1024.0 * 1024.0); };
+        std::printf("%-14s %9zu %11.1f %11.1f %10.1f %11.2f %11.2f %11.1f %11.1f\n", name, count,
+            mbs(save, bytes), mbs(load, bytes), bytes / n, save.allocationsPerIteration / n,
+            load.allocationsPerIteration / n, mbs(base64, bytes), mbs(print, static_cast<double>(os.tellp())));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; ++i)
+        counts.push_back(std::strtoull(argv[i], nullptr, 10));
+    if (counts.empty())
+        counts = { 10, 1000, 100000 };
+
+    std::printf("%-14s %9s %11s %11s %10s %11s %11s %11s %11s\n", "workload", "objects", "save MB/s", "load MB/s",
+        "bytes/obj", "allocs/save", "allocs/load", "base64 MB/s", "print MB/s");
+    for (size_t count : counts) {
+        runWorkload<cpp_serializers_benchmark::Monster>("monster", count);
+        runWorkload<workloads::IntegerRecord>("integer-heavy", count);
+        runWorkload<workloads::StringRecord>("string-heavy", count);
+        runWorkload<workloads::FloatRecord>("float-heavy", count);
+    }
+}
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+# SPDX-License-Identifier: BSL-1.0
+"""Compile time benchmark: generates a translation unit with N DEFINE_SERIALIZABLE types that are saved,
+loaded, compared and printed, compiles it and reports the build time and the peak memory of the compiler."""
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+MEMBER_TYPES = ["int", "float", "std::string", "std::vector<int>", "std::optional<double>", "std::array<short, 4>", "bool", "uint64_t"]
+NESTING_DEPTH = 8
+
+
+def generate(types, members):
+    lines = ["#include <tser/tser.hpp>", "#include <array>", "#include <cstdint>", "#include <optional>", "#include <sstream>", "#include <vector>", ""]
+    for t in range(types):
+        fields = []
+        for m in range(members):
+            # the fourth member nests the previous type, in chains of at most NESTING_DEPTH types
+            nested = m == 3 and t % NESTING_DEPTH != 0
+            fields.append(("Type%d" % (t - 1) if nested else MEMBER_TYPES[(t + m) % len(MEMBER_TYPES)], "member%d" % m))
+        lines.append("struct Type%d {" % t)
+        lines.append("    DEFINE_SERIALIZABLE(Type%d, %s)" % (t, ", ".join(name for _, name in fields)))
+        lines += ["    %s %s{};" % field for field in fields]
+        lines.append("};")
+    lines += ["", "size_t use_types() {", "    tser::BinaryArchive ba;", "    std::stringstream ss;", "    size_t equal = 0;"]
+    for t in range(types):
+        lines.append("    { Type%d t; ba.save(t); auto loaded = ba.load<Type%d>(); equal += loaded == t && !(loaded < t); ss << t; }" % (t, t))
+    lines += ["    return equal + ss.str().size();", "}", ""]
+    return "\n".join(lines)
+
+
+def child_usage():
+    """returns the cpu seconds and the peak memory in MB of the compiler, or None if resource isn't available"""
+    try:
+        import resource
+    except ImportError:
+        return None
+    usage = resource.getrusage(resource.RUSAGE_CHILDREN)
+    # kilobytes on linux, bytes on macOS
+    memory = usage.ru_maxrss / (1024.0 * 1024.0) if sys.platform == "darwin" else usage.ru_maxrss / 1024.0
+    return usage.ru_utime + usage.ru_stime, memory
+
+
+def main():
+    root = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--types", type=int, default=200, help="number of generated types")
+    parser.add_argument("--members", type=int, default=8, help="members per type")
+    parser.add_argument("--compiler", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--include", default=os.path.join(root, "include"), help="tser include directory")
+    parser.add_argument("--flags", default="-std=c++17 -O0", help="compiler flags")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        source = os.path.join(directory, "compile_bench.cpp")
+        with open(source, "w") as f:
+            f.write(generate(args.types, args.members))
+        command = [args.compiler] + args.flags.split() + ["-I", args.include, "-c", source, "-o", os.path.join(directory, "compile_bench.o")]
+        start = time.perf_counter()
+        result = subprocess.run(command)
+        seconds = time.perf_counter() - start
+    if result.returncode != 0:
+        return result.returncode
+    usage = child_usage()
+    print("%d types with %d members: %.2f s%s" % (args.types, args.members, seconds,
+                                                  "" if usage is None else " (%.2f s cpu), %.0f MB peak memory" % usage))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,116 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tser/tser.hpp"
+namespace tser {
+    //learned initial capacity for archives of one message type: jumps to the largest recent message and decays slowly,
+    //so archives neither regrow for typical messages nor keep the capacity of a single huge message forever
+    class SizeHint {
+        std::atomic<size_t> m_size{ 0 };
+    public:
+        void record(size_t size) {
+            size_t hint = m_size.load(std::memory_order_relaxed), next;
+            //concurrent records of a larger size must not be overwritten by a decayed older hint
+            do next = std::max(size, hint - hint / 16);
+            while (next != hint && !m_size.compare_exchange_weak(hint, next, std::memory_order_relaxed));
+        }
+        size_t get() const { return m_size.load(std::memory_order_relaxed); }
+        template<typename T>
+        static SizeHint& of() {
+            static SizeHint hint;
+            return hint;
+        }
+    };
+    //hands out reset archives that keep their capacity, instead of constructing a new BinaryArchive per message
+    //every thread uses its own shard of the pool, so concurrent acquire/release calls rarely contend for a lock
+    class ArchivePool {
+        static constexpr size_t g_shardCount = 8;
+        struct alignas(64) Shard {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<BinaryArchive>> archives;
+        };
+        std::array<Shard, g_shardCount> m_shards;
+        size_t m_maxPerShard;
+        static Shard& shard_of(std::array<Shard, g_shardCount>& shards) {
+            static std::atomic<size_t> threadCount{ 0 };
+            static thread_local const size_t index = threadCount.fetch_add(1, std::memory_order_relaxed) % g_shardCount;
+            return shards[index];
+        }
+    public:
+        //returns the archive to the pool when it goes out of scope
+        class Handle {
+            ArchivePool* m_pool = nullptr;
+            std::unique_ptr<BinaryArchive> m_archive;
+            SizeHint* m_hint = nullptr;
+        public:
+            Handle(ArchivePool* pool, std::unique_ptr<BinaryArchive> archive, SizeHint* hint) : m_pool(pool), m_archive(std::move(archive)), m_hint(hint) {}
+            Handle(Handle&&) noexcept = default;
+            Handle& operator=(Handle&& other) noexcept {
+                if (this != &other) {
+                    release();
+                    m_pool = std::exchange(other.m_pool, nullptr);
+                    m_archive = std::move(other.m_archive);
+                    m_hint = std::exchange(other.m_hint, nullptr);
+                }
+                return *this;
+            }
+            ~Handle() { release(); }
+            void release() {
+                if (m_pool && m_archive)
+                    m_pool->release(std::move(m_archive), m_hint);
+                m_pool = nullptr;
+            }
+            BinaryArchive& operator*() const { return *m_archive; }
+            BinaryArchive* operator->() const { return m_archive.get(); }
+            BinaryArchive* get() const { return m_archive.get(); }
+        };
+        explicit ArchivePool(size_t maxPooledArchives = 64) : m_maxPerShard(std::max<size_t>(1, maxPooledArchives / g_shardCount)) {}
+        ArchivePool(const ArchivePool&) = delete;
+        ArchivePool& operator=(const ArchivePool&) = delete;
+        //an empty archive, with T the capacity is reserved from the sizes of the recent T messages
+        template<typename T = void>
+        Handle acquire() {
+            std::unique_ptr<BinaryArchive> archive;
+            {
+                auto& shard = shard_of(m_shards);
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (!shard.archives.empty()) {
+                    archive = std::move(shard.archives.back());
+                    shard.archives.pop_back();
+                }
+            }
+            if (!archive)
+                archive = std::make_unique<BinaryArchive>(0);
+            SizeHint* hint = nullptr;
+            if constexpr (!std::is_void_v<T>) {
+                hint = &SizeHint::of<T>();
+                archive->reserve(hint->get());
+            }
+            return Handle(this, std::move(archive), hint);
+        }
+        void release(std::unique_ptr<BinaryArchive> archive, SizeHint* hint = nullptr) {
+            const size_t size = archive->get_buffer().size();
+            if (hint)
+                hint->record(size);
+            //archives over caller provided buffers and ones that grew far beyond the typical size aren't kept
+            const size_t typical = std::max(hint ? hint->get() : size, size_t(1024));
+            if (archive->uses_external_buffer() || archive->capacity() > 4 * typical)
+                return;
+            archive->reset();
+            archive->use_string_dictionary(false);
+            archive->set_growth_policy(GrowthPolicy());
+            auto& shard = shard_of(m_shards);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.archives.size() < m_maxPerShard)
+                shard.archives.push_back(std::move(archive));
+        }
+    };
+}
@@ -0,0 +1,146 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "tser/tser.hpp"
+namespace tser {
+    //columnar (structure of arrays) encoding of vectors of tser types: every member is written as its own column,
+    //members that are tser types themselves are split into columns recursively (e.g. "pos.x", "pos.y", "pos.z")
+    //format: varint row count, then for every column: uint64 byte size (so other columns can be skipped), the values of all rows
+    namespace detail {
+        template<class T> constexpr bool is_column_group_v = is_tser_t_v<T> && !is_detected_v<has_free_save_t, T> && !is_detected_v<has_custom_save_t, T>;
+        //get maps a row to the (nested) member that belongs to the current column
+        template<size_t I, typename Get>
+        auto member_getter(const Get& get) {
+            return [&get](auto& row) -> decltype(auto) { return std::get<I>(get(row).members()); };
+        }
+        template<typename Row, typename Get>
+        void save_columns(BinaryArchive& ba, const Row* rows, size_t count, const Get& get);
+        template<typename Row, typename Get, size_t... I>
+        void save_member_columns(BinaryArchive& ba, const Row* rows, size_t count, const Get& get, std::index_sequence<I...>) {
+            (save_columns(ba, rows, count, member_getter<I>(get)), ...);
+        }
+        template<typename Row, typename Get>
+        void save_columns(BinaryArchive& ba, const Row* rows, size_t count, const Get& get) {
+            using M = std::decay_t<decltype(get(*rows))>;
+            if constexpr (is_column_group_v<M>) {
+                using Tuple = std::decay_t<decltype(std::declval<const M&>().members())>;
+                save_member_columns(ba, rows, count, get, std::make_index_sequence<std::tuple_size_v<Tuple>>());
+            }
+            else {
+                const uint64_t placeholder = 0;
+                ba.save_bytes(&placeholder, sizeof(uint64_t));
+                const size_t offset = ba.get_buffer().size();
+                if constexpr (max_serialized_size<M>() != 0)
+                    ba.reserve(offset + count * max_serialized_size<M>());
+                for (size_t i = 0; i < count; ++i)
+                    ba.save(get(rows[i]));
+                //an archive without heap fallback may have dropped the placeholder, the column is lost anyway
+                if (ba.overflowed())
+                    return;
+                const auto size = static_cast<uint64_t>(ba.get_buffer().size() - offset);
+                std::memcpy(ba.data() + offset - sizeof(uint64_t), &size, sizeof(uint64_t));
+            }
+        }
+        template<typename Row, typename Get>
+        void load_columns(BinaryArchive& ba, Row* rows, size_t count, const Get& get);
+        template<typename Row, typename Get, size_t... I>
+        void load_member_columns(BinaryArchive& ba, Row* rows, size_t count, const Get& get, std::index_sequence<I...>) {
+            (load_columns(ba, rows, count, member_getter<I>(get)), ...);
+        }
+        template<typename Row, typename Get>
+        void load_columns(BinaryArchive& ba, Row* rows, size_t count, const Get& get) {
+            using M = std::decay_t<decltype(get(*rows))>;
+            if constexpr (is_column_group_v<M>) {
+                using Tuple = std::decay_t<decltype(std::declval<M&>().members())>;
+                load_member_columns(ba, rows, count, get, std::make_index_sequence<std::tuple_size_v<Tuple>>());
+            }
+            else {
+                ba.set_read_offset(ba.read_offset() + sizeof(uint64_t));
+                for (size_t i = 0; i < count; ++i)
+                    ba.reload(get(rows[i]));
+            }
+        }
+        //calls f(name, static_cast<M*>(nullptr)) for every column in the order they are written
+        template<typename M, typename F>
+        void for_each_column(std::string& path, F& f);
+        template<typename M, typename F, size_t... I>
+        void for_each_member_column(std::string& path, F& f, std::index_sequence<I...>) {
+            using Tuple = std::decay_t<decltype(std::declval<M&>().members())>;
+            const size_t size = path.size();
+            ((path.append(size == 0 ? "" : ".").append(M::_memberNames[I]),
+                for_each_column<std::decay_t<std::tuple_element_t<I, Tuple>>>(path, f), path.resize(size)), ...);
+        }
+        template<typename M, typename F>
+        void for_each_column(std::string& path, F& f) {
+            if constexpr (is_column_group_v<M>) {
+                using Tuple = std::decay_t<decltype(std::declval<M&>().members())>;
+                for_each_member_column<M>(path, f, std::make_index_sequence<std::tuple_size_v<Tuple>>());
+            }
+            else
+                f(std::string_view(path), static_cast<M*>(nullptr));
+        }
+    }
+    //std::vector of a tser type that is written column by column, e.g. for analytics that only scan a few members
+    template<typename T>
+    class columnar : public std::vector<T> {
+        static_assert(detail::is_column_group_v<T>, "columnar needs a type with DEFINE_SERIALIZABLE and without custom save functions");
+    public:
+        using std::vector<T>::vector;
+        void save(BinaryArchive& ba) const {
+            ba.save(this->size());
+            detail::save_columns(ba, this->data(), this->size(), [](const T& row) -> const T& { return row; });
+        }
+        //overwrites the vector, the members of existing elements are reloaded in place (see BinaryArchive::reload)
+        void load(BinaryArchive& ba) {
+            this->resize(ba.load<size_t>());
+            detail::load_columns(ba, this->data(), this->size(), [](T& row) -> T& { return row; });
+        }
+    };
+    //loads a single column of a columnar<T> (e.g. "hp" or "pos.x") into out, the other columns are skipped
+    //the read position moves past the whole columnar<T>, reset it to load another column of the same vector
+    //returns false (without reading anything) if T has no column with that name and value type
+    //columns can't be skipped in string dictionary mode, because later strings may refer to strings of skipped columns
+    template<typename T, typename V>
+    bool load_column(BinaryArchive& ba, std::string_view name, std::vector<V>& out) {
+        size_t columnCount = 0, column = SIZE_MAX;
+        std::string path;
+        auto findColumn = [&](std::string_view columnName, auto* type) {
+            if (column == SIZE_MAX && columnName == name && std::is_same_v<std::remove_pointer_t<decltype(type)>, V>)
+                column = columnCount;
+            ++columnCount;
+        };
+        detail::for_each_column<T>(path, findColumn);
+        if (column == SIZE_MAX)
+            return false;
+        const size_t count = ba.load<size_t>();
+        for (size_t i = 0; i < columnCount; ++i) {
+            uint64_t size = 0;
+            ba.load_bytes(&size, sizeof(uint64_t));
+            const size_t end = ba.read_offset() + static_cast<size_t>(size);
+            if (i == column) {
+                out.resize(count);
+                if constexpr (detail::is_bulk_container_v<std::vector<V>>) {
+                    if (detail::has_contiguous_layout<V>()) {
+                        ba.load_bytes(out.data(), count * sizeof(V));
+                        continue;
+                    }
+                }
+                for (size_t j = 0; j < count; ++j) {
+                    if constexpr (std::is_same_v<V, bool>)
+                        out[j] = ba.load<bool>();
+                    else
+                        ba.reload(out[j]);
+                }
+            }
+            else
+                ba.set_read_offset(end);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,200 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "tser/tser.hpp"
+namespace tser {
+    //dependency free block compression in the LZ4 block format (greedy matching, 64KiB blocks)
+    namespace detail {
+        constexpr size_t g_lzMinMatch = 4, g_lzLastLiterals = 5, g_lzMatchLimit = 12, g_lzHashLog = 12;
+        inline uint32_t lz_read32(const char* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        inline uint32_t lz_hash(uint32_t seq) { return (seq * 2654435761u) >> (32 - g_lzHashLog); }
+        inline char* lz_write_length(char* out, size_t len) {
+            for (; len >= 255; len -= 255)
+                *out++ = static_cast<char>(255);
+            *out++ = static_cast<char>(len);
+            return out;
+        }
+        inline char* lz_write_sequence(char* out, const char* literals, size_t litLen, size_t matchLen) {
+            char* token = out++;
+            *token = static_cast<char>((litLen >= 15 ? 15 : litLen) << 4 | (matchLen >= 15 ? 15 : matchLen));
+            if (litLen >= 15)
+                out = lz_write_length(out, litLen - 15);
+            std::memcpy(out, literals, litLen);
+            return out + litLen;
+        }
+    }
+    static constexpr size_t g_lzBlockSize = 1 << 16;
+    //worst case size of a compressed block (incompressible input)
+    constexpr size_t lz_max_compressed_size(size_t size) { return size + size / 255 + 16; }
+    //compresses at most g_lzBlockSize bytes into out (which needs lz_max_compressed_size(size) bytes), returns the compressed size
+    inline size_t compress_lz_block(const char* in, size_t size, char* out) {
+        using namespace detail;
+        uint16_t table[1 << g_lzHashLog] = {};
+        const char* const end = in + size;
+        const char* anchor = in;
+        char* op = out;
+        if (size > g_lzMatchLimit) {
+            const char* const matchLimit = end - g_lzMatchLimit, * const matchEnd = end - g_lzLastLiterals;
+            for (const char* ip = in + 1; ip < matchLimit;) {
+                const uint32_t seq = lz_read32(ip), h = lz_hash(seq);
+                const char* ref = in + table[h];
+                table[h] = static_cast<uint16_t>(ip - in);
+                if (ref >= ip || lz_read32(ref) != seq) {
+                    //skip faster through incompressible data
+                    ip += 1 + (static_cast<size_t>(ip - anchor) >> 6);
+                    continue;
+                }
+                while (ip > anchor && ref > in && ip[-1] == ref[-1])
+                    --ip, --ref;
+                const char* mp = ip + g_lzMinMatch, * rp = ref + g_lzMinMatch;
+                while (mp < matchEnd && *mp == *rp)
+                    ++mp, ++rp;
+                const size_t matchLen = static_cast<size_t>(mp - ip) - g_lzMinMatch, offset = static_cast<size_t>(ip - ref);
+                op = lz_write_sequence(op, anchor, static_cast<size_t>(ip - anchor), matchLen);
+                *op++ = static_cast<char>(offset & 255);
+                *op++ = static_cast<char>(offset >> 8);
+                if (matchLen >= 15)
+                    op = lz_write_length(op, matchLen - 15);
+                anchor = ip = mp;
+            }
+        }
+        op = lz_write_sequence(op, anchor, static_cast<size_t>(end - anchor), 0);
+        return static_cast<size_t>(op - out);
+    }
+    //decompresses a block into exactly outSize bytes, returns false if the input is malformed
+    inline bool decompress_lz_block(const char* in, size_t size, char* out, size_t outSize) {
+        const auto* ip = reinterpret_cast<const unsigned char*>(in), * const ie = ip + size;
+        char* op = out, * const oe = out + outSize;
+        auto readLength = [&](size_t len) {
+            for (unsigned char b = 255; b == 255 && ip < ie; len += b)
+                b = *ip++;
+            return len;
+        };
+        while (ip < ie) {
+            const unsigned token = *ip++;
+            size_t litLen = token >> 4;
+            if (litLen == 15)
+                litLen = readLength(litLen);
+            if (litLen > static_cast<size_t>(ie - ip) || litLen > static_cast<size_t>(oe - op))
+                return false;
+            std::memcpy(op, ip, litLen);
+            op += litLen, ip += litLen;
+            if (ip == ie)
+                break;
+            if (ie - ip < 2)
+                return false;
+            const size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+            ip += 2;
+            size_t matchLen = token & 15;
+            if (matchLen == 15)
+                matchLen = readLength(matchLen);
+            matchLen += detail::g_lzMinMatch;
+            if (offset == 0 || offset > static_cast<size_t>(op - out) || matchLen > static_cast<size_t>(oe - op))
+                return false;
+            const char* match = op - offset;
+            if (offset >= matchLen)
+                std::memcpy(op, match, matchLen);
+            else for (size_t i = 0; i < matchLen; ++i)
+                op[i] = match[i];
+            op += matchLen;
+        }
+        return op == oe;
+    }
+    //appends one frame block (varint raw size, varint compressed size (0 means stored), payload) to out
+    //blocks are independent, so they can be written and read one at a time when streaming
+    inline void compress_lz_append(std::string_view block, std::string& out) {
+        constexpr size_t maxHeaderSize = 20;
+        const size_t offset = out.size();
+        out.resize(offset + maxHeaderSize + lz_max_compressed_size(block.size()));
+        char* const header = out.data() + offset, * const payload = header + maxHeaderSize;
+        size_t compressedSize = compress_lz_block(block.data(), block.size(), payload);
+        const bool stored = compressedSize >= block.size();
+        size_t headerSize = encode_varint(block.size(), header);
+        headerSize += encode_varint(stored ? size_t(0) : compressedSize, header + headerSize);
+        if (stored)
+            std::memcpy(header + headerSize, block.data(), compressedSize = block.size());
+        else
+            std::memmove(header + headerSize, payload, compressedSize);
+        out.resize(offset + headerSize + compressedSize);
+    }
+    inline void compress_lz(std::string_view in, std::string& out, size_t blockSize = g_lzBlockSize) {
+        blockSize = blockSize == 0 || blockSize > g_lzBlockSize ? g_lzBlockSize : blockSize;
+        for (size_t offset = 0; offset < in.size(); offset += blockSize)
+            compress_lz_append(in.substr(offset, blockSize), out);
+    }
+    inline std::string compress_lz(std::string_view in, size_t blockSize = g_lzBlockSize) {
+        std::string out;
+        compress_lz(in, out, blockSize);
+        return out;
+    }
+    namespace detail {
+        //reads the header of the next frame block, returns false if it is malformed or truncated
+        inline bool lz_read_header(std::string_view& in, size_t& rawSize, size_t& compressedSize) {
+            auto readVarint = [&](size_t& value) {
+                size_t i = 0;
+                while (i < in.size() && i < 10 && (in[i] & 128))
+                    ++i;
+                if (i == in.size() || i == 10)
+                    return false;
+                in.remove_prefix(decode_varint(value, in.data()));
+                return true;
+            };
+            return readVarint(rawSize) && readVarint(compressedSize) && rawSize <= g_lzBlockSize
+                && (compressedSize != 0 ? compressedSize : rawSize) <= in.size();
+        }
+    }
+    //computes the decompressed size by only reading the block headers, returns false if the input is malformed
+    inline bool decompressed_lz_size(std::string_view in, size_t& size) {
+        size_t rawSize = 0, compressedSize = 0;
+        for (size = 0; !in.empty(); size += rawSize) {
+            if (!detail::lz_read_header(in, rawSize, compressedSize))
+                return false;
+            in.remove_prefix(compressedSize != 0 ? compressedSize : rawSize);
+        }
+        return true;
+    }
+    //decompresses into exactly outSize bytes (see decompressed_lz_size), returns false if the input is malformed
+    inline bool decompress_lz(std::string_view in, char* out, size_t outSize) {
+        size_t rawSize = 0, compressedSize = 0;
+        char* const end = out + outSize;
+        for (; !in.empty(); out += rawSize) {
+            if (!detail::lz_read_header(in, rawSize, compressedSize) || rawSize > static_cast<size_t>(end - out))
+                return false;
+            if (compressedSize == 0)
+                std::memcpy(out, in.data(), rawSize);
+            else if (!decompress_lz_block(in.data(), compressedSize, out, rawSize))
+                return false;
+            in.remove_prefix(compressedSize != 0 ? compressedSize : rawSize);
+        }
+        return out == end;
+    }
+    //appends the decompressed blocks to out, returns false if the input is malformed or truncated
+    inline bool decompress_lz(std::string_view in, std::string& out) {
+        size_t size = 0;
+        if (!decompressed_lz_size(in, size))
+            return false;
+        const size_t offset = out.size();
+        out.resize(offset + size);
+        return decompress_lz(in, out.data() + offset, size);
+    }
+    //compresses the serialized content of the archive without copying it first
+    inline std::string compress(const BinaryArchive& ba, size_t blockSize = g_lzBlockSize) {
+        return compress_lz(ba.get_buffer(), blockSize);
+    }
+    //decompresses directly into the buffer of the archive, returns false (and resets the archive) if the input is malformed
+    inline bool decompress(std::string_view compressed, BinaryArchive& ba) {
+        size_t size = 0;
+        if (decompressed_lz_size(compressed, size)) {
+            //an empty archive without storage has no buffer, but holds the empty payload fine
+            char* buffer = ba.initialize(size);
+            if ((buffer != nullptr || size == 0) && decompress_lz(compressed, buffer, size))
+                return true;
+        }
+        ba.reset();
+        return false;
+    }
+}
@@ -0,0 +1,189 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "tser/tser.hpp"
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define TSER_CRC32C_ARM
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define TSER_CRC32C_SSE42 __attribute__((target("sse4.2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <nmmintrin.h>
+#define TSER_CRC32C_SSE42
+#endif
+namespace tser {
+    namespace detail {
+        //slicing-by-8 tables for the scalar fallback of the castagnoli polynomial (reversed 0x1EDC6F41)
+        static constexpr auto g_crc32cTables = []() { std::array<std::array<uint32_t, 256>, 8> tables{};
+        for (uint32_t i = 0; i < 256u; ++i) { uint32_t c = i; for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1; tables[0][i] = c; }
+        for (size_t t = 1; t < 8; ++t) for (size_t i = 0; i < 256u; ++i) tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 255u];
+        return tables; }();
+        inline uint32_t crc32c_scalar(uint32_t crc, const char* data, size_t size) {
+            const auto& t = g_crc32cTables;
+            const auto* p = reinterpret_cast<const uint8_t*>(data);
+            for (; size >= 8; size -= 8, p += 8) {
+                const uint32_t lo = crc ^ (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24);
+                const uint32_t hi = uint32_t(p[4]) | uint32_t(p[5]) << 8 | uint32_t(p[6]) << 16 | uint32_t(p[7]) << 24;
+                crc = t[7][lo & 255u] ^ t[6][(lo >> 8) & 255u] ^ t[5][(lo >> 16) & 255u] ^ t[4][lo >> 24] ^
+                      t[3][hi & 255u] ^ t[2][(hi >> 8) & 255u] ^ t[1][(hi >> 16) & 255u] ^ t[0][hi >> 24];
+            }
+            for (; size > 0; --size, ++p)
+                crc = (crc >> 8) ^ t[0][(crc ^ *p) & 255u];
+            return crc;
+        }
+#if defined(TSER_CRC32C_SSE42)
+        TSER_CRC32C_SSE42 inline uint32_t crc32c_sse42(uint32_t crc, const char* data, size_t size) {
+            for (; size >= 8; size -= 8, data += 8) {
+                uint64_t v;
+                std::memcpy(&v, data, sizeof(v));
+#if defined(__x86_64__) || defined(_M_X64)
+                crc = static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+#else
+                crc = _mm_crc32_u32(_mm_crc32_u32(crc, static_cast<uint32_t>(v)), static_cast<uint32_t>(v >> 32));
+#endif
+            }
+            for (; size > 0; --size, ++data)
+                crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data));
+            return crc;
+        }
+        //the instruction is only used if the cpu we run on supports it, so no -msse4.2 is needed
+        inline bool has_sse42() {
+#if defined(__SSE4_2__)
+            return true;
+#elif defined(_MSC_VER)
+            static const bool supported = []() { int info[4]; __cpuid(info, 1); return (info[2] & (1 << 20)) != 0; }();
+            return supported;
+#else
+            static const bool supported = __builtin_cpu_supports("sse4.2");
+            return supported;
+#endif
+        }
+#elif defined(TSER_CRC32C_ARM)
+        inline uint32_t crc32c_arm(uint32_t crc, const char* data, size_t size) {
+            for (; size >= 8; size -= 8, data += 8) {
+                uint64_t v;
+                std::memcpy(&v, data, sizeof(v));
+                crc = __crc32cd(crc, v);
+            }
+            for (; size > 0; --size, ++data)
+                crc = __crc32cb(crc, static_cast<uint8_t>(*data));
+            return crc;
+        }
+#endif
+    }
+    //crc32c (castagnoli) checksum, uses the SSE4.2/ARMv8 crc32 instructions if the cpu supports them
+    //the result of a previous call can be passed as crc to checksum data in several parts
+    inline uint32_t crc32c(std::string_view data, uint32_t crc = 0) {
+#if defined(TSER_CRC32C_SSE42)
+        if (detail::has_sse42())
+            return ~detail::crc32c_sse42(~crc, data.data(), data.size());
+        return ~detail::crc32c_scalar(~crc, data.data(), data.size());
+#elif defined(TSER_CRC32C_ARM)
+        return ~detail::crc32c_arm(~crc, data.data(), data.size());
+#else
+        return ~detail::crc32c_scalar(~crc, data.data(), data.size());
+#endif
+    }
+    namespace detail {
+        //frames are checksummed in blocks, so that each block is hashed while it is still in the cache
+        static constexpr size_t g_crcBlockSize = 16 * 1024;
+        inline size_t crc_block_count(size_t payloadSize) {
+            return payloadSize == 0 ? 1 : (payloadSize + g_crcBlockSize - 1) / g_crcBlockSize;
+        }
+        //folds every block of a frame that is being written into its checksum as soon as the block is complete
+        struct SaveFrame : FrameCheck {
+            size_t blockStart;
+            std::vector<uint32_t>& crcs;
+            static bool advance(FrameCheck& fc, const char* data, size_t position) {
+                auto& frame = static_cast<SaveFrame&>(fc);
+                for (; frame.blockStart + g_crcBlockSize <= position; frame.blockStart += g_crcBlockSize)
+                    frame.crcs.push_back(crc32c(std::string_view(data + frame.blockStart, g_crcBlockSize)));
+                frame.end = frame.blockStart + g_crcBlockSize;
+                return true;
+            }
+        };
+        //verifies every block of a frame that is being read before the first byte of the block is decoded
+        //once a block failed every further read fails as well (and yields default values)
+        struct LoadFrame : FrameCheck {
+            size_t blockStart, payloadEnd, blockCount, verified;
+            bool failed;
+            static bool advance(FrameCheck& fc, const char* data, size_t position) {
+                auto& frame = static_cast<LoadFrame&>(fc);
+                for (; !frame.failed && frame.verified < frame.blockCount && frame.blockStart < position; ++frame.verified) {
+                    const size_t size = std::min(g_crcBlockSize, frame.payloadEnd - frame.blockStart);
+                    uint32_t crc;
+                    std::memcpy(&crc, data + frame.payloadEnd + frame.verified * sizeof(uint32_t), sizeof(uint32_t));
+                    frame.failed = crc32c(std::string_view(data + frame.blockStart, size)) != crc;
+                    frame.blockStart += frame.failed ? 0 : size;
+                }
+                frame.end = frame.failed ? 0 : frame.verified == frame.blockCount ? SIZE_MAX : frame.blockStart;
+                return !frame.failed;
+            }
+        };
+    }
+    //saves t as a checked frame: [uint32 payload size][payload][uint32 crc32c for every 16 KiB block of the payload]
+    //the archive reports each completed block while t is encoded, so the checksum is computed on cache resident bytes
+    //returns false if the frame doesn't fit into an archive without heap fallback (or the payload is larger than 4 GiB)
+    template<typename T>
+    bool save_checked(BinaryArchive& ba, const T& t) {
+        static thread_local std::vector<uint32_t> crcs;
+        const size_t frameOffset = ba.get_buffer().size(), payloadOffset = frameOffset + sizeof(uint32_t), firstCrc = crcs.size();
+        const uint32_t placeholder = 0;
+        ba.save_bytes(&placeholder, sizeof(uint32_t));
+        if (ba.overflowed() || ba.get_buffer().size() != payloadOffset)
+            return false;
+        detail::SaveFrame frame{ { &detail::SaveFrame::advance, payloadOffset + detail::g_crcBlockSize }, payloadOffset, crcs };
+        detail::FrameCheck* outer = ba.frame_check();
+        ba.set_frame_check(&frame);
+        ba.save(t);
+        ba.set_frame_check(outer);
+        const size_t payloadEnd = ba.get_buffer().size();
+        if (ba.overflowed() || payloadEnd - payloadOffset > UINT32_MAX) {
+            crcs.resize(firstCrc);
+            return false;
+        }
+        detail::SaveFrame::advance(frame, ba.data(), payloadEnd);
+        if (frame.blockStart < payloadEnd || crcs.size() == firstCrc)
+            crcs.push_back(crc32c(std::string_view(ba.data() + frame.blockStart, payloadEnd - frame.blockStart)));
+        const auto payloadSize = static_cast<uint32_t>(payloadEnd - payloadOffset);
+        std::memcpy(ba.data() + frameOffset, &payloadSize, sizeof(uint32_t));
+        ba.save_bytes(crcs.data() + firstCrc, (crcs.size() - firstCrc) * sizeof(uint32_t));
+        crcs.resize(firstCrc);
+        return !ba.overflowed();
+    }
+    //loads a frame written by save_checked, each block is verified before any of its bytes are decoded into t
+    //returns false (and leaves the read position untouched) if the frame is truncated or corrupted, t may be partially loaded then
+    template<typename T>
+    bool load_checked(BinaryArchive& ba, T& t) {
+        const std::string_view remaining = ba.get_buffer().substr(ba.read_offset());
+        uint32_t payloadSize = 0;
+        if (remaining.size() < sizeof(uint32_t))
+            return false;
+        std::memcpy(&payloadSize, remaining.data(), sizeof(uint32_t));
+        const size_t blockCount = detail::crc_block_count(payloadSize);
+        if (payloadSize > remaining.size() - sizeof(uint32_t) || blockCount * sizeof(uint32_t) > remaining.size() - sizeof(uint32_t) - payloadSize)
+            return false;
+        const size_t frameOffset = ba.read_offset(), payloadOffset = frameOffset + sizeof(uint32_t), payloadEnd = payloadOffset + payloadSize;
+        detail::LoadFrame frame{ { &detail::LoadFrame::advance, payloadOffset }, payloadOffset, payloadEnd, blockCount, 0, false };
+        detail::FrameCheck* outer = ba.frame_check();
+        ba.set_read_offset(payloadOffset);
+        ba.set_frame_check(&frame);
+        ba.load(t);
+        ba.set_frame_check(outer);
+        //blocks the payload didn't read from are verified as well
+        if (!detail::LoadFrame::advance(frame, ba.get_buffer().data(), SIZE_MAX)) {
+            ba.set_read_offset(frameOffset);
+            return false;
+        }
+        ba.set_read_offset(payloadEnd + blockCount * sizeof(uint32_t));
+        return true;
+    }
+}
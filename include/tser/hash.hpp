@@ -0,0 +1,132 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include "tser/tser.hpp"
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+namespace tser {
+    //structural hashing that walks members(), tuples, containers and pointers directly instead of serializing the object
+    //the hash is consistent with the (deep) equality of tser types: e.g. equal unordered containers hash equally, -0.0 == 0.0
+    namespace detail {
+        constexpr uint64_t g_hashSecret0 = 0xa0761d6478bd642full, g_hashSecret1 = 0xe7037ed1a0b428dbull;
+        //folded 64x64->128 bit multiplication
+        inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+            const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+            return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            uint64_t high;
+            const uint64_t low = _umul128(a, b, &high);
+            return low ^ high;
+#else
+            const uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+            const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+            const uint64_t lo = t + (rm1 << 32), hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+            return lo ^ hi;
+#endif
+        }
+        inline uint64_t hash_read(const char* p, size_t size) {
+            uint64_t v = 0;
+            std::memcpy(&v, p, size);
+            return v;
+        }
+        //hashes a contiguous range of bytes 16 bytes at a time
+        inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+            const char* p = static_cast<const char*>(data);
+            seed ^= g_hashSecret0;
+            size_t i = size;
+            for (; i > 16; i -= 16, p += 16)
+                seed = hash_mix(hash_read(p, 8) ^ g_hashSecret1, hash_read(p + 8, 8) ^ seed);
+            const uint64_t a = i != 0 ? hash_read(p, i < 8 ? i : 8) : 0, b = i > 8 ? hash_read(p + 8, i - 8) : 0;
+            return hash_mix(g_hashSecret1 ^ size, hash_mix(a ^ g_hashSecret1, b ^ seed));
+        }
+        inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+            return hash_mix(seed ^ g_hashSecret0, value ^ g_hashSecret1);
+        }
+        template<class T> using has_hasher_t = typename T::hasher;
+        //types whose equality is exactly the equality of their bytes: scalars without padding bits
+        //and tser types whose members() cover every byte of the object (has_contiguous_layout has to hold as well)
+        template<typename T>
+        constexpr bool is_hashed_as_bytes();
+        template<class T, class Tuple> struct has_byte_members : std::false_type {};
+        template<class T, class... Ts> struct has_byte_members<T, std::tuple<Ts...>> :
+            std::bool_constant<(sizeof(Ts) + ... + 0) == sizeof(T) && (is_hashed_as_bytes<std::decay_t<Ts>>() && ...)> {};
+        template<typename T>
+        constexpr bool is_hashed_as_bytes() {
+            if constexpr (!std::has_unique_object_representations_v<T> || is_detected_v<has_free_save_t, T> || is_detected_v<has_custom_save_t, T>)
+                return false;
+            else if constexpr (is_tser_t_v<T>)
+                return std::is_default_constructible_v<T> && has_byte_members<T, std::decay_t<decltype(std::declval<T&>().members())>>::value;
+            else if constexpr (is_container_v<T>)
+                return is_array<T>::value && is_hashed_as_bytes<std::decay_t<decltype(*std::begin(std::declval<T&>()))>>();
+            else
+                return std::is_integral_v<T> || std::is_enum_v<T>;
+        }
+    }
+    template<typename T>
+    uint64_t hash_value(const T& t, uint64_t seed = 0) {
+        using V = std::decay_t<T>;
+        if constexpr (is_detected_v<has_free_save_t, V> || is_detected_v<has_custom_save_t, V>) {
+            //custom save functions define what is part of the value, so the serialized representation is hashed
+            BinaryArchive ba(sizeof(V) + 1);
+            ba.save(t);
+            const auto bytes = ba.get_buffer();
+            return detail::hash_bytes(bytes.data(), bytes.size(), seed);
+        }
+        else if constexpr (is_tser_t_v<V>)
+            return hash_value(t.members(), seed);
+        else if constexpr (is_tuple_v<V> && !is_container_v<V>)
+            return std::apply([&](auto& ... tVal) { ((seed = hash_value(tVal, seed)), ...); return seed; }, t);
+        else if constexpr (is_pointer_like_v<V>)
+            return t ? hash_value(*t, detail::hash_combine(seed, 1)) : detail::hash_combine(seed, 0);
+        else if constexpr (is_variant_v<V>) {
+            if (t.valueless_by_exception())
+                return detail::hash_combine(seed, 0);
+            return std::visit([&](auto& alt) { return hash_value(alt, detail::hash_combine(seed, t.index() + 1)); }, t);
+        }
+        else if constexpr (is_container_v<V>) {
+            using VT = std::decay_t<decltype(*std::begin(t))>;
+            const auto size = static_cast<uint64_t>(std::distance(std::begin(t), std::end(t)));
+            if constexpr (is_detected_v<has_data_t, V> && detail::is_hashed_as_bytes<VT>()) {
+                if (detail::has_contiguous_layout<VT>())
+                    return detail::hash_bytes(std::data(t), size * sizeof(VT), detail::hash_combine(seed, size));
+            }
+            if constexpr (is_detected_v<detail::has_hasher_t, V>) {
+                //the iteration order of unordered containers is unspecified, so the element hashes are combined commutatively
+                uint64_t sum = 0;
+                for (auto& val : t)
+                    sum += hash_value(val);
+                return detail::hash_combine(detail::hash_combine(seed, size), sum);
+            }
+            else {
+                seed = detail::hash_combine(seed, size);
+                for (auto& val : t)
+                    seed = hash_value(val, seed);
+                return seed;
+            }
+        }
+        else if constexpr (std::is_floating_point_v<V>)
+            return detail::hash_combine(seed, static_cast<uint64_t>(std::hash<V>()(t == V(0) ? V(0) : t)));
+        else if constexpr (std::is_integral_v<V> || std::is_enum_v<V>) {
+            uint64_t v = 0;
+            std::memcpy(&v, &t, sizeof(V) < sizeof(v) ? sizeof(V) : sizeof(v));
+            return detail::hash_combine(seed, v);
+        }
+        else if constexpr (std::is_empty_v<V>)
+            return seed;
+        else
+            return detail::hash_bytes(std::addressof(t), sizeof(V), seed);
+    }
+    //hash functor e.g. for std::unordered_map<Key, Value, tser::hash<Key>>
+    template<typename T>
+    struct hash {
+        size_t operator()(const T& t) const { return static_cast<size_t>(hash_value(t)); }
+    };
+}
@@ -0,0 +1,168 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "tser/tser.hpp"
+namespace tser {
+    //delta serialization: diff(old, new) only encodes what changed, apply_patch(old, patch) turns old into new in place
+    //tser types: (member index + 1, member patch)... 0
+    //resizable sequences (vector, deque) and arrays: new size (not for arrays), (element index + 1, element patch)... 0, appended elements
+    //maps: removed keys, changed (key, value patch), added (key, value)
+    //pointers/optionals: true + pointee patch if both sides are set, otherwise false + the new value
+    //everything else is stored as the new value
+    namespace detail {
+        template<class T> using has_index_t = decltype(std::declval<T&>()[size_t()]);
+        template<class T> using has_key_index_t = decltype(std::declval<T&>()[std::declval<const typename T::key_type&>()]);
+        template<class T> constexpr bool has_custom_serialization_v = is_detected_v<has_free_save_t, T> || is_detected_v<has_custom_save_t, T>;
+        template<class T, bool = is_detected_v<has_index_t, T>>
+        struct is_patchable_sequence : std::false_type {};
+        template<class T>
+        struct is_patchable_sequence<T, true> : std::bool_constant<!is_detected_v<has_compare_t, T> && is_container_v<T>
+            && std::is_lvalue_reference_v<has_index_t<T>> && (is_array<T>::value || is_detected_v<has_resize_t, T>)> {};
+        template<class T> constexpr bool is_patchable_map_v = is_detected_v<has_mapped_t, T> && is_detected_v<has_key_index_t, T>;
+
+        //deep equality, pointers are compared by their pointees (like they are serialized)
+        //types without operator== are only compared bytewise if they have no padding, otherwise they always count as changed
+        template<typename T>
+        bool patch_equal(const T& lhs, const T& rhs) {
+            if constexpr (is_tser_t_v<T> && !has_custom_serialization_v<T>)
+                return patch_equal(lhs.members(), rhs.members());
+            else if constexpr (is_tuple_v<T> && !is_container_v<T>)
+                return std::apply([&](auto& ... l) { return std::apply([&](auto& ... r) { return (patch_equal(l, r) && ...); }, rhs); }, lhs);
+            else if constexpr (is_pointer_like_v<T>)
+                return lhs && rhs ? patch_equal(*lhs, *rhs) : !lhs && !rhs;
+            else if constexpr (is_patchable_sequence<T>::value)
+                return std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs), std::end(rhs), [](auto& l, auto& r) { return patch_equal(l, r); });
+            else if constexpr (is_detected_v<has_equal_t, T>)
+                return lhs == rhs;
+            else if constexpr (std::has_unique_object_representations_v<T>)
+                return std::memcmp(std::addressof(lhs), std::addressof(rhs), sizeof(T)) == 0;
+            else
+                return false;
+        }
+    }
+    template<typename T>
+    void diff(const T& oldValue, const T& newValue, BinaryArchive& patch) {
+        if constexpr (is_tser_t_v<T> && !detail::has_custom_serialization_v<T>) {
+            size_t index = 0;
+            auto diffMember = [&](auto& o, auto& n) {
+                ++index;
+                if (!detail::patch_equal(o, n)) {
+                    patch.save(index);
+                    diff(o, n, patch);
+                }
+            };
+            std::apply([&](auto& ... o) { std::apply([&](auto& ... n) { (diffMember(o, n), ...); }, newValue.members()); }, oldValue.members());
+            patch.save(size_t(0));
+        }
+        else if constexpr (detail::is_patchable_sequence<T>::value) {
+            const size_t oldSize = std::size(oldValue), newSize = std::size(newValue);
+            if constexpr (!detail::is_array<T>::value)
+                patch.save(newSize);
+            for (size_t i = 0; i < std::min(oldSize, newSize); ++i)
+                if (!detail::patch_equal(oldValue[i], newValue[i])) {
+                    patch.save(i + 1);
+                    diff(oldValue[i], newValue[i], patch);
+                }
+            patch.save(size_t(0));
+            for (size_t i = oldSize; i < newSize; ++i)
+                patch.save(newValue[i]);
+        }
+        else if constexpr (detail::is_patchable_map_v<T>) {
+            std::vector<const typename T::value_type*> removed, changed, added;
+            for (auto& entry : oldValue)
+                if (newValue.find(entry.first) == newValue.end())
+                    removed.push_back(&entry);
+            for (auto& entry : newValue) {
+                auto it = oldValue.find(entry.first);
+                if (it == oldValue.end())
+                    added.push_back(&entry);
+                else if (!detail::patch_equal(it->second, entry.second))
+                    changed.push_back(&entry);
+            }
+            patch.save(removed.size());
+            for (auto* entry : removed)
+                patch.save(entry->first);
+            patch.save(changed.size());
+            for (auto* entry : changed) {
+                patch.save(entry->first);
+                diff(oldValue.find(entry->first)->second, entry->second, patch);
+            }
+            patch.save(added.size());
+            for (auto* entry : added)
+                patch.save(*entry);
+        }
+        else if constexpr (is_pointer_like_v<T> && !detail::has_custom_serialization_v<T>) {
+            const bool isPatch = oldValue && newValue;
+            patch.save(isPatch);
+            if (isPatch)
+                diff(*oldValue, *newValue, patch);
+            else
+                patch.save(newValue);
+        }
+        else
+            patch.save(newValue);
+    }
+    template<typename T>
+    std::string diff(const T& oldValue, const T& newValue) {
+        BinaryArchive patch;
+        diff(oldValue, newValue, patch);
+        return std::string(patch.get_buffer());
+    }
+    template<typename T>
+    void apply_patch(T& t, BinaryArchive& patch) {
+        if constexpr (is_tser_t_v<T> && !detail::has_custom_serialization_v<T>) {
+            size_t index = 0, next = patch.load<size_t>();
+            //member indices are ascending, so a single pass over the members is enough
+            auto applyMember = [&](auto& member) {
+                if (next == ++index) {
+                    apply_patch(member, patch);
+                    next = patch.load<size_t>();
+                }
+            };
+            std::apply([&](auto& ... member) { (applyMember(member), ...); }, t.members());
+        }
+        else if constexpr (detail::is_patchable_sequence<T>::value) {
+            size_t oldSize = std::size(t), newSize = oldSize;
+            if constexpr (!detail::is_array<T>::value)
+                newSize = patch.load<size_t>();
+            for (size_t next = patch.load<size_t>(); next != 0; next = patch.load<size_t>())
+                apply_patch(t[next - 1], patch);
+            if constexpr (!detail::is_array<T>::value) {
+                t.resize(newSize);
+                for (size_t i = oldSize; i < newSize; ++i)
+                    t[i] = patch.load<typename T::value_type>();
+            }
+        }
+        else if constexpr (detail::is_patchable_map_v<T>) {
+            for (size_t i = 0, removed = patch.load<size_t>(); i < removed; ++i)
+                t.erase(patch.load<typename T::key_type>());
+            for (size_t i = 0, changed = patch.load<size_t>(); i < changed; ++i)
+                apply_patch(t[patch.load<typename T::key_type>()], patch);
+            for (size_t i = 0, added = patch.load<size_t>(); i < added; ++i) {
+                auto key = patch.load<typename T::key_type>();
+                t[std::move(key)] = patch.load<typename T::mapped_type>();
+            }
+        }
+        else if constexpr (is_pointer_like_v<T> && !detail::has_custom_serialization_v<T>) {
+            if (patch.load<bool>())
+                apply_patch(*t, patch);
+            else
+                patch.reload(t);
+        }
+        //reloading in place reuses the capacity and the existing (raw) pointees of t
+        else
+            patch.reload(t);
+    }
+    template<typename T>
+    void apply_patch(T& t, std::string_view patch) {
+        BinaryArchive ba(0);
+        ba.initialize(patch);
+        apply_patch(t, ba);
+    }
+}
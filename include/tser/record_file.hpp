@@ -0,0 +1,305 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "tser/tser.hpp"
+#include "tser/crc32c.hpp"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+//append only file of tser records that can be looked up without reading the rest of the file:
+//[record 0][record 1]...[index][uint64 index offset][uint64 index size][uint32 crc32c of the index][magic "TSRF"]
+//the index holds the offset, size and crc32c of every record and the optional keys of the records
+//appending writes the new records and a new index after the old footer, only the last footer of the file is read
+namespace tser {
+    namespace detail {
+        struct RecordIndex {
+            DEFINE_SERIALIZABLE(RecordIndex, offsets, sizes, checksums, keys)
+            std::vector<uint64_t> offsets, sizes;
+            std::vector<uint32_t> checksums;
+            //empty if no record has a key, otherwise one (possibly empty) key per record
+            std::vector<std::string> keys;
+        };
+        constexpr std::string_view g_recordFileMagic = "TSRF";
+        constexpr size_t g_recordFooterSize = 2 * sizeof(uint64_t) + sizeof(uint32_t) + 4;
+        inline bool seek(std::FILE* file, uint64_t offset, int origin) {
+#ifdef _WIN32
+            return _fseeki64(file, static_cast<long long>(offset), origin) == 0;
+#else
+            return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+        }
+        inline uint64_t tell(std::FILE* file) {
+#ifdef _WIN32
+            return static_cast<uint64_t>(_ftelli64(file));
+#else
+            return static_cast<uint64_t>(ftello(file));
+#endif
+        }
+        //reads the offset of the index from the footer, returns false if the footer is invalid
+        inline bool read_index_offset(std::string_view footer, uint64_t footerOffset, uint64_t& indexOffset) {
+            uint64_t indexSize = 0;
+            if (footer.size() != g_recordFooterSize || footer.substr(footer.size() - 4) != g_recordFileMagic)
+                return false;
+            std::memcpy(&indexOffset, footer.data(), sizeof(uint64_t));
+            std::memcpy(&indexSize, footer.data() + sizeof(uint64_t), sizeof(uint64_t));
+            return indexOffset < footerOffset && footerOffset - indexOffset == indexSize;
+        }
+        //tail holds the last bytes of the file (at least the index and the footer), starting at tailOffset
+        //returns false if the footer or the index is missing or corrupted
+        inline bool read_record_index(std::string_view tail, uint64_t tailOffset, RecordIndex& index) {
+            if (tail.size() < g_recordFooterSize)
+                return false;
+            const uint64_t footerOffset = tailOffset + tail.size() - g_recordFooterSize;
+            uint64_t indexOffset = 0;
+            if (!read_index_offset(tail.substr(tail.size() - g_recordFooterSize), footerOffset, indexOffset) || indexOffset < tailOffset)
+                return false;
+            const std::string_view indexBytes = tail.substr(static_cast<size_t>(indexOffset - tailOffset), static_cast<size_t>(footerOffset - indexOffset));
+            uint32_t crc = 0;
+            std::memcpy(&crc, tail.data() + tail.size() - g_recordFooterSize + 2 * sizeof(uint64_t), sizeof(uint32_t));
+            if (crc32c(indexBytes) != crc)
+                return false;
+            BinaryArchive ba(0);
+            ba.initialize(indexBytes);
+            index = RecordIndex{};
+            ba.load(index);
+            const size_t count = index.offsets.size();
+            if (index.sizes.size() != count || index.checksums.size() != count || (!index.keys.empty() && index.keys.size() != count))
+                return false;
+            //every record has to lie in front of the index
+            for (size_t i = 0; i < count; ++i)
+                if (index.offsets[i] > indexOffset || index.sizes[i] > indexOffset - index.offsets[i])
+                    return false;
+            return true;
+        }
+    }
+    //appends records to a file, the records are collected in a batch archive and written once it holds batchSize bytes
+    //the index is written by close() (or the destructor), a file without a valid index can't be read by RecordReader
+    class RecordWriter {
+        std::FILE* m_file = nullptr;
+        BinaryArchive m_batch;
+        detail::RecordIndex m_index;
+        size_t m_batchSize;
+        bool m_failed = false;
+        //bytes already written to the file (start of the batch)
+        uint64_t m_fileSize = 0;
+    public:
+        explicit RecordWriter(size_t batchSize = 1 << 20) : m_batch(batchSize), m_batchSize(batchSize) {}
+        RecordWriter(const RecordWriter&) = delete;
+        RecordWriter& operator=(const RecordWriter&) = delete;
+        ~RecordWriter() { close(); }
+        //with append the records of an existing file are kept, the new records and the next index are written after its footer
+        bool open(const std::string& path, bool append = false) {
+            close();
+            m_failed = false;
+            m_index = detail::RecordIndex{};
+            m_fileSize = 0;
+            if (append && (m_file = std::fopen(path.c_str(), "r+b")) != nullptr) {
+                //only the footer and the index are read, the old index stays valid until the next close() writes a new one
+                std::array<char, detail::g_recordFooterSize> footer;
+                uint64_t fileSize = 0, indexOffset = 0;
+                std::string tail;
+                if (detail::seek(m_file, 0, SEEK_END) && (fileSize = detail::tell(m_file)) >= footer.size()
+                    && detail::seek(m_file, fileSize - footer.size(), SEEK_SET) && std::fread(footer.data(), 1, footer.size(), m_file) == footer.size()
+                    && detail::read_index_offset(std::string_view(footer.data(), footer.size()), fileSize - footer.size(), indexOffset)
+                    && detail::seek(m_file, indexOffset, SEEK_SET)) {
+                    tail.resize(static_cast<size_t>(fileSize - indexOffset));
+                    if (std::fread(tail.data(), 1, tail.size(), m_file) == tail.size() && detail::read_record_index(tail, indexOffset, m_index)
+                        && detail::seek(m_file, fileSize, SEEK_SET)) {
+                        m_fileSize = fileSize;
+                        return true;
+                    }
+                }
+                std::fclose(m_file);
+                m_file = nullptr;
+                return false;
+            }
+            m_file = std::fopen(path.c_str(), "wb");
+            return m_file != nullptr;
+        }
+        bool is_open() const { return m_file != nullptr; }
+        //number of records in the file, including the ones that are still in the batch
+        size_t size() const { return m_index.offsets.size(); }
+        //returns false if the file isn't open or writing a batch failed
+        template<typename T>
+        bool append(const T& t, std::string_view key = {}) {
+            if (m_file == nullptr || m_failed)
+                return false;
+            const size_t offset = m_batch.get_buffer().size();
+            m_batch.save(t);
+            if (!key.empty() && m_index.keys.empty())
+                m_index.keys.resize(size());
+            if (!m_index.keys.empty())
+                m_index.keys.emplace_back(key);
+            const std::string_view record = m_batch.get_buffer().substr(offset);
+            m_index.offsets.push_back(m_fileSize + offset);
+            m_index.sizes.push_back(record.size());
+            m_index.checksums.push_back(crc32c(record));
+            return m_batch.get_buffer().size() < m_batchSize || flush();
+        }
+        //writes the batch to the file, the records are only readable after close()
+        bool flush() {
+            const std::string_view batch = m_batch.get_buffer();
+            if (m_file == nullptr || m_failed || (!batch.empty() && std::fwrite(batch.data(), 1, batch.size(), m_file) != batch.size())) {
+                m_failed = true;
+                return false;
+            }
+            m_fileSize += batch.size();
+            m_batch.reset();
+            return true;
+        }
+        //writes the remaining batch, the index and the footer and closes the file
+        bool close() {
+            if (m_file == nullptr)
+                return !m_failed;
+            if (flush()) {
+                BinaryArchive ba;
+                ba.save(m_index);
+                const std::string_view index = ba.get_buffer();
+                const uint64_t indexOffset = m_fileSize, indexSize = index.size();
+                const uint32_t crc = crc32c(index);
+                std::array<char, detail::g_recordFooterSize> footer;
+                std::memcpy(footer.data(), &indexOffset, sizeof(uint64_t));
+                std::memcpy(footer.data() + sizeof(uint64_t), &indexSize, sizeof(uint64_t));
+                std::memcpy(footer.data() + 2 * sizeof(uint64_t), &crc, sizeof(uint32_t));
+                std::memcpy(footer.data() + 2 * sizeof(uint64_t) + sizeof(uint32_t), detail::g_recordFileMagic.data(), 4);
+                m_failed = std::fwrite(index.data(), 1, index.size(), m_file) != index.size()
+                    || std::fwrite(footer.data(), 1, footer.size(), m_file) != footer.size();
+            }
+            m_failed = std::fclose(m_file) != 0 || m_failed;
+            m_file = nullptr;
+            return !m_failed;
+        }
+    };
+    //maps a file written by RecordWriter into memory, only the index is decoded when opening it
+    //records are decoded on demand directly from the mapping, concurrent loads from multiple threads are fine
+    class RecordReader {
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+#ifdef _WIN32
+        HANDLE m_mapping = nullptr;
+#endif
+        detail::RecordIndex m_index;
+        std::unordered_map<std::string_view, size_t> m_keys;
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+        RecordReader() = default;
+        explicit RecordReader(const std::string& path) { open(path); }
+        RecordReader(const RecordReader&) = delete;
+        RecordReader& operator=(const RecordReader&) = delete;
+        ~RecordReader() { close(); }
+        //returns false if the file can't be mapped or has no valid index
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER size;
+            if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+                m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (m_mapping != nullptr) {
+                    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+                    m_size = m_data != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+                }
+            }
+            CloseHandle(file);
+#else
+            const int file = ::open(path.c_str(), O_RDONLY);
+            if (file < 0)
+                return false;
+            struct stat info;
+            if (fstat(file, &info) == 0 && info.st_size > 0) {
+                void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+                if (data != MAP_FAILED) {
+                    m_data = static_cast<const char*>(data);
+                    m_size = static_cast<size_t>(info.st_size);
+                }
+            }
+            ::close(file);
+#endif
+            if (m_data == nullptr || !detail::read_record_index(std::string_view(m_data, m_size), 0, m_index)) {
+                close();
+                return false;
+            }
+            //later records replace earlier ones with the same key
+            for (size_t i = 0; i < m_index.keys.size(); ++i)
+                if (!m_index.keys[i].empty())
+                    m_keys[m_index.keys[i]] = i;
+            return true;
+        }
+        void close() {
+#ifdef _WIN32
+            if (m_data != nullptr)
+                UnmapViewOfFile(m_data);
+            if (m_mapping != nullptr)
+                CloseHandle(m_mapping);
+            m_mapping = nullptr;
+#else
+            if (m_data != nullptr)
+                munmap(const_cast<char*>(m_data), m_size);
+#endif
+            m_data = nullptr;
+            m_size = 0;
+            m_index = detail::RecordIndex{};
+            m_keys.clear();
+        }
+        bool is_open() const { return m_data != nullptr; }
+        size_t size() const { return m_index.offsets.size(); }
+        //index of the last record with this key or npos
+        size_t find(std::string_view key) const {
+            const auto it = m_keys.find(key);
+            return it == m_keys.end() ? npos : it->second;
+        }
+        std::string_view key(size_t index) const { return index < m_index.keys.size() ? std::string_view(m_index.keys[index]) : std::string_view(); }
+        //the serialized bytes of a record
+        std::string_view record(size_t index) const {
+            if (index >= size())
+                return {};
+            return std::string_view(m_data + m_index.offsets[index], static_cast<size_t>(m_index.sizes[index]));
+        }
+        //decodes the record into t (like BinaryArchive::reload)
+        //returns false if there is no such record or its checksum doesn't match, corrupted records are never decoded
+        template<typename T>
+        bool load(size_t index, T& t) const {
+            if (index >= size())
+                return false;
+            const std::string_view bytes = record(index);
+            if (crc32c(bytes) != m_index.checksums[index])
+                return false;
+            //the archive only reads from the mapping, it never writes to it
+            BinaryArchive ba(0);
+            ba.use_buffer(const_cast<char*>(bytes.data()), bytes.size(), false);
+            ba.initialize(bytes.size());
+            ba.reload(t);
+            return true;
+        }
+        template<typename T>
+        bool load(std::string_view key, T& t) const { return load(find(key), t); }
+        template<typename T>
+        T load(size_t index) const {
+            T t{};
+            load(index, t);
+            return t;
+        }
+    };
+}
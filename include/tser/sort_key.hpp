@@ -0,0 +1,109 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "tser/tser.hpp"
+namespace tser {
+    //order preserving ("memcomparable") encoding: comparing two keys with memcmp gives the same ordering as tser::compare
+    //integers are stored big endian (with a flipped sign bit), floats order preserving, strings escaped and terminated
+    namespace detail {
+        template<typename U>
+        void append_big_endian(std::string& out, U value) {
+            char bytes[sizeof(U)];
+            for (size_t i = 0; i < sizeof(U); ++i)
+                bytes[i] = static_cast<char>(static_cast<unsigned char>(value >> (8 * (sizeof(U) - 1 - i))));
+            out.append(bytes, sizeof(U));
+        }
+        //0x00 is escaped as 0x00 0xFF and the sequence is terminated by 0x00 0x01, so shorter prefixes order first
+        template<typename It>
+        void append_escaped(std::string& out, It first, It last) {
+            for (; first != last; ++first) {
+                out.push_back(static_cast<char>(*first));
+                if (static_cast<unsigned char>(*first) == 0)
+                    out.push_back(static_cast<char>(0xFF));
+            }
+            out.push_back('\0');
+            out.push_back('\1');
+        }
+    }
+    template<typename T>
+    void append_sort_key(std::string& out, const T& t) {
+        using V = std::decay_t<T>;
+        if constexpr (is_tser_t_v<V>)
+            append_sort_key(out, t.members());
+        else if constexpr (is_detected_v<has_compare_t, V>)
+            detail::append_escaped(out, std::begin(t), std::end(t));
+        else if constexpr (is_container_v<V>) {
+            using VT = std::decay_t<decltype(*std::begin(t))>;
+            if constexpr (detail::is_array<V>::value) {
+                for (auto& val : t)
+                    append_sort_key(out, val);
+            }
+            else if constexpr (!is_detected_v<has_smaller_t, V>) {
+                //containers without operator< are ordered by size first
+                detail::append_big_endian(out, static_cast<uint64_t>(std::size(t)));
+                for (auto& val : t)
+                    append_sort_key(out, val);
+            }
+            else if constexpr (std::is_same_v<VT, unsigned char> || std::is_same_v<VT, std::byte>)
+                detail::append_escaped(out, std::begin(t), std::end(t));
+            else {
+                //every element is prefixed by 0x01 and the sequence is terminated by 0x00
+                for (auto& val : t) {
+                    out.push_back('\1');
+                    append_sort_key(out, val);
+                }
+                out.push_back('\0');
+            }
+        }
+        else if constexpr (is_tuple_v<V>)
+            std::apply([&](auto& ... tVal) { (append_sort_key(out, tVal), ...); }, t);
+        else if constexpr (is_detected_v<has_optional_t, V>) {
+            out.push_back(t ? '\1' : '\0');
+            if (t)
+                append_sort_key(out, *t);
+        }
+        else if constexpr (is_variant_v<V>) {
+            //index + 1 first, so valueless variants order first
+            using Index = std::conditional_t<(std::variant_size_v<V> < 255), uint8_t, uint64_t>;
+            detail::append_big_endian(out, static_cast<Index>(t.index() + 1));
+            if (!t.valueless_by_exception())
+                std::visit([&](auto& alt) { append_sort_key(out, alt); }, t);
+        }
+        else if constexpr (std::is_enum_v<V>)
+            append_sort_key(out, static_cast<std::underlying_type_t<V>>(t));
+        else if constexpr (is_detected_v<has_value_range_t, V> && !std::is_integral_v<V>)
+            append_sort_key(out, detail::range_offset(t));
+        else if constexpr (std::is_same_v<V, bool>)
+            out.push_back(t ? '\1' : '\0');
+        else if constexpr (std::is_integral_v<V>) {
+            using U = std::make_unsigned_t<V>;
+            auto value = static_cast<U>(t);
+            if constexpr (std::is_signed_v<V>)
+                value ^= static_cast<U>(U(1) << (sizeof(V) * CHAR_BIT - 1));
+            detail::append_big_endian(out, value);
+        }
+        else if constexpr (std::is_floating_point_v<V> && (sizeof(V) == 4 || sizeof(V) == 8)) {
+            using U = std::conditional_t<sizeof(V) == 4, uint32_t, uint64_t>;
+            constexpr U signBit = U(1) << (sizeof(V) * CHAR_BIT - 1);
+            const V normalized = t == V(0) ? V(0) : t;
+            U bits;
+            std::memcpy(&bits, &normalized, sizeof(V));
+            detail::append_big_endian(out, (bits & signBit) ? static_cast<U>(~bits) : static_cast<U>(bits | signBit));
+        }
+        else if constexpr (std::is_empty_v<V>)
+            return;
+        else
+            static_assert(std::is_void_v<V>, "there is no order preserving encoding for this type");
+    }
+    template<typename T>
+    std::string sort_key(const T& t) {
+        std::string key;
+        append_sort_key(key, t);
+        return key;
+    }
+}
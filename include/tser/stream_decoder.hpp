@@ -0,0 +1,280 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "tser/tser.hpp"
+namespace tser {
+    //incremental decoding of messages that arrive in pieces (e.g. over several TCP reads)
+    //a resumable state machine walks the serialized structure of T while bytes arrive and remembers its position
+    //(a stack of frames), so previously received bytes are never scanned again and load never reads past the end
+    namespace detail {
+        enum class ScanResult { Done, NeedMore, Pushed, Malformed };
+        struct ScanState;
+        struct ScanFrame {
+            ScanResult(*step)(ScanState&, ScanFrame&);
+            size_t index = 0, count = 0;
+        };
+        struct ScanState {
+            std::string_view bytes;
+            size_t cursor = 0;
+            std::vector<ScanFrame> stack;
+            bool skip(size_t size) {
+                if (bytes.size() - cursor < size)
+                    return false;
+                cursor += size;
+                return true;
+            }
+            //NeedMore if the varint isn't complete yet, Malformed if it is longer than any 64 bit varint
+            ScanResult read_varint(uint64_t& value) {
+                for (size_t i = cursor; i < bytes.size(); ++i) {
+                    if (i - cursor >= 10)
+                        return ScanResult::Malformed;
+                    if (!(static_cast<unsigned char>(bytes[i]) & 128)) {
+                        decode_varint(value, bytes.data() + cursor);
+                        cursor = i + 1;
+                        return ScanResult::Done;
+                    }
+                }
+                return bytes.size() - cursor >= 10 ? ScanResult::Malformed : ScanResult::NeedMore;
+            }
+        };
+        template<typename T>
+        ScanResult scan_step(ScanState& s, ScanFrame& f);
+        template<typename T>
+        ScanResult scan_pointee(ScanState& s, ScanFrame& f);
+        template<typename T>
+        ScanResult push_scan(ScanState& s) {
+            s.stack.push_back(ScanFrame{ &scan_step<T> });
+            return ScanResult::Pushed;
+        }
+        template<typename Tuple, size_t... I>
+        ScanResult scan_members(ScanState& s, ScanFrame& f, std::index_sequence<I...>) {
+            if constexpr (sizeof...(I) == 0)
+                return ScanResult::Done;
+            else {
+                static constexpr ScanResult(*steps[])(ScanState&, ScanFrame&) = { &scan_step<std::decay_t<std::tuple_element_t<I, Tuple>>>... };
+                if (f.index == sizeof...(I))
+                    return ScanResult::Done;
+                //f is invalidated by the push, so it is updated first
+                s.stack.push_back(ScanFrame{ steps[f.index++] });
+                return ScanResult::Pushed;
+            }
+        }
+        template<typename Tuple, size_t... I>
+        ScanResult scan_packed_members(ScanState& s, ScanFrame& f, std::index_sequence<I...>) {
+            constexpr size_t headerSize = header_size<Tuple>::value;
+            if (f.index == 0) {
+                f.count = s.cursor;
+                if (!s.skip(headerSize))
+                    return ScanResult::NeedMore;
+                f.index = 1;
+            }
+            if constexpr (sizeof...(I) != 0) {
+                //members that are only stored in the header are skipped, pointees only if their presence bit is set
+                static constexpr bool inHeader[] = { is_header_member_v<std::decay_t<std::tuple_element_t<I, Tuple>>>... };
+                static constexpr bool isPointer[] = { (is_header_member_v<std::decay_t<std::tuple_element_t<I, Tuple>>>
+                    && is_pointer_like_v<std::decay_t<std::tuple_element_t<I, Tuple>>>)... };
+                static constexpr size_t bits[] = { header_bits<std::decay_t<std::tuple_element_t<I, Tuple>>>()... };
+                static constexpr ScanResult(*steps[])(ScanState&, ScanFrame&) = { &scan_pointee<std::decay_t<std::tuple_element_t<I, Tuple>>>... };
+                size_t bit = 0;
+                for (size_t i = 0; i < f.index - 1; ++i)
+                    bit += bits[i];
+                for (size_t i = f.index - 1; i < sizeof...(I); bit += bits[i], ++i) {
+                    const bool present = !inHeader[i] || (isPointer[i] && (static_cast<unsigned char>(s.bytes[f.count + bit / 8]) >> (bit % 8) & 1u));
+                    if (present) {
+                        f.index = i + 2;
+                        s.stack.push_back(ScanFrame{ steps[i] });
+                        return ScanResult::Pushed;
+                    }
+                }
+            }
+            return ScanResult::Done;
+        }
+        //an index past the alternatives has no value (see BinaryArchive::save_variant)
+        template<typename T, size_t... I>
+        ScanResult scan_alternative(ScanState& s, uint64_t index, std::index_sequence<I...>) {
+            static constexpr ScanResult(*steps[])(ScanState&, ScanFrame&) = { &scan_step<std::variant_alternative_t<I, T>>... };
+            if (index >= sizeof...(I))
+                return ScanResult::Done;
+            s.stack.push_back(ScanFrame{ steps[index] });
+            return ScanResult::Pushed;
+        }
+        //scans the pointee of pointers inside of bit packed types (their presence flag is in the header) and other members as they are
+        template<typename T>
+        ScanResult scan_pointee(ScanState& s, ScanFrame& f) {
+            if constexpr (is_pointer_like_v<T> && is_header_member_v<T>) {
+                f.step = &scan_step<std::decay_t<decltype(*std::declval<T&>())>>;
+                return f.step(s, f);
+            }
+            else
+                return scan_step<T>(s, f);
+        }
+        template<typename T>
+        ScanResult scan_step(ScanState& s, ScanFrame& f) {
+            static_assert(!is_detected_v<has_free_save_t, T> && !is_detected_v<has_custom_save_t, T>,
+                "the StreamDecoder can't know the size of types with custom save functions");
+            if constexpr (is_tser_t_v<T> && is_trivially_serializable<T>())
+                return s.skip(sizeof(T)) ? ScanResult::Done : ScanResult::NeedMore;
+            else if constexpr (is_tser_t_v<T>) {
+                using Tuple = std::decay_t<decltype(std::declval<T&>().members())>;
+                if constexpr (is_detected_v<has_pack_bits_t, T>)
+                    return scan_packed_members<Tuple>(s, f, std::make_index_sequence<std::tuple_size_v<Tuple>>());
+                else
+                    return scan_members<Tuple>(s, f, std::make_index_sequence<std::tuple_size_v<Tuple>>());
+            }
+            else if constexpr (is_detected_v<has_value_range_t, T>)
+                return s.skip((range_bits<T>() + 7) / 8) ? ScanResult::Done : ScanResult::NeedMore;
+            else if constexpr (is_tuple_v<T> && !is_container_v<T>)
+                return scan_members<T>(s, f, std::make_index_sequence<std::tuple_size_v<T>>());
+            else if constexpr (is_pointer_like_v<T>) {
+                if (f.index != 0)
+                    return ScanResult::Done;
+                if (s.cursor == s.bytes.size())
+                    return ScanResult::NeedMore;
+                if (s.bytes[s.cursor++] == 0)
+                    return ScanResult::Done;
+                f.index = 1;
+                return push_scan<std::decay_t<decltype(*std::declval<T&>())>>(s);
+            }
+            else if constexpr (is_variant_v<T>) {
+                if (f.index != 0)
+                    return ScanResult::Done;
+                uint64_t index = 0;
+                if (const auto result = s.read_varint(index); result != ScanResult::Done)
+                    return result;
+                f.index = 1;
+                return scan_alternative<T>(s, index, std::make_index_sequence<std::variant_size_v<T>>());
+            }
+            else if constexpr (is_container_v<T>) {
+                using VT = std::decay_t<decltype(*std::begin(std::declval<T&>()))>;
+                constexpr bool isBytes = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> || is_bulk_container_v<T>;
+                if (f.index == 0) {
+                    if constexpr (is_array<T>::value)
+                        f.count = sizeof(T) / sizeof(VT);
+                    else {
+                        uint64_t size = 0;
+                        if (const auto result = s.read_varint(size); result != ScanResult::Done)
+                            return result;
+                        //the size is untrusted, a size whose byte count doesn't fit into size_t can't be valid
+                        if (size > SIZE_MAX || (is_detected_v<has_bit_proxy_t, T> && size > SIZE_MAX - 7) || (isBytes && size > SIZE_MAX / sizeof(VT)))
+                            return ScanResult::Malformed;
+                        f.count = static_cast<size_t>(size);
+                    }
+                    f.index = 1;
+                    if constexpr (is_detected_v<has_bit_proxy_t, T>)
+                        f.count = (f.count + 7) / 8;
+                    else if constexpr (isBytes)
+                        f.count *= sizeof(VT);
+                }
+                if constexpr (isBytes || is_detected_v<has_bit_proxy_t, T>)
+                    return s.skip(f.count) ? ScanResult::Done : ScanResult::NeedMore;
+                else {
+                    if (f.count == 0)
+                        return ScanResult::Done;
+                    --f.count;
+                    if constexpr (is_detected_v<has_mapped_t, T>)
+                        return push_scan<std::pair<typename T::key_type, typename T::mapped_type>>(s);
+                    else
+                        return push_scan<VT>(s);
+                }
+            }
+            else if constexpr (std::is_integral_v<T> && sizeof(T) > 2) {
+                uint64_t value = 0;
+                return s.read_varint(value);
+            }
+            else
+                return s.skip(sizeof(T)) ? ScanResult::Done : ScanResult::NeedMore;
+        }
+    }
+    //feed() the received bytes and call next() until it returns false:
+    //  decoder.feed(data, received);
+    //  while (decoder.next(message)) handle(message);
+    //complete messages are decoded straight from the fed bytes, only the incomplete tail is copied into the buffer of the decoder
+    //so the fed bytes have to stay valid until next() returned false, the string dictionary mode isn't supported
+    //string_views of decoded messages point into the fed bytes or the buffer of the decoder, they stay valid until the next feed()
+    template<typename T>
+    class StreamDecoder {
+        BinaryArchive m_archive;
+        //reads the bytes of the last feed() in place while none of the earlier bytes are pending
+        BinaryArchive m_input;
+        bool m_inInput = false;
+        detail::ScanState m_state;
+        size_t m_maxMessageSize;
+        //bytes of already decoded messages at the start of the buffer (or of the fed bytes)
+        size_t m_consumed = 0;
+        bool m_failed = false;
+        BinaryArchive& source() { return m_inInput ? m_input : m_archive; }
+        //copies the fed bytes that weren't decoded yet into the buffer
+        void keep_tail() {
+            m_archive.reset();
+            m_archive.save_bytes(m_input.data() + m_consumed, m_input.get_buffer().size() - m_consumed);
+            m_consumed = 0;
+            m_inInput = false;
+        }
+    public:
+        //messages that would be larger than maxMessageSize bytes put the decoder into the failed state
+        explicit StreamDecoder(size_t maxMessageSize = SIZE_MAX) : m_archive(0), m_input(0), m_maxMessageSize(maxMessageSize) {
+            m_state.stack.push_back(detail::ScanFrame{ &detail::scan_step<T> });
+        }
+        void feed(const char* data, size_t size) { feed(std::string_view(data, size)); }
+        void feed(std::string_view bytes) {
+            if (m_inInput)
+                keep_tail();
+            if (buffered() == 0) {
+                //the input archive only reads from the bytes, they are never written
+                m_archive.reset();
+                m_input.use_buffer(const_cast<char*>(bytes.data()), bytes.size(), false);
+                m_input.initialize(bytes.size());
+                m_consumed = 0;
+                m_inInput = true;
+                return;
+            }
+            //the decoded messages are only dropped once they take up half of the buffer, so each byte is moved at most once on average
+            if (m_consumed != 0 && m_consumed >= buffered()) {
+                m_archive.initialize(m_archive.get_buffer().substr(m_consumed));
+                m_consumed = 0;
+            }
+            m_archive.save_bytes(bytes.data(), bytes.size());
+        }
+        //returns true if a complete message was decoded into t (overwritten in place, see BinaryArchive::reload), false if more data is needed or decoding failed
+        bool next(T& t) {
+            if (m_failed)
+                return false;
+            m_state.bytes = source().get_buffer().substr(m_consumed);
+            while (!m_state.stack.empty()) {
+                auto& frame = m_state.stack.back();
+                const auto result = frame.step(m_state, frame);
+                if (result == detail::ScanResult::Done)
+                    m_state.stack.pop_back();
+                else if (result == detail::ScanResult::NeedMore) {
+                    m_failed = m_state.bytes.size() >= m_maxMessageSize;
+                    if (m_inInput && !m_failed)
+                        keep_tail();
+                    return false;
+                }
+                else if (result == detail::ScanResult::Malformed) {
+                    m_failed = true;
+                    return false;
+                }
+            }
+            const size_t messageSize = m_state.cursor;
+            if (messageSize > m_maxMessageSize) {
+                m_failed = true;
+                return false;
+            }
+            source().set_read_offset(m_consumed);
+            source().reload(t);
+            //skip the decoded message and start scanning the next one
+            m_consumed += messageSize;
+            m_state.cursor = 0;
+            m_state.stack.push_back(detail::ScanFrame{ &detail::scan_step<T> });
+            return true;
+        }
+        bool failed() const { return m_failed; }
+        //bytes that were received but not decoded yet
+        size_t buffered() const { return (m_inInput ? m_input : m_archive).get_buffer().size() - m_consumed; }
+    };
+}
@@ -1,33 +1,46 @@
 // Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
 // SPDX-License-Identifier: BSL-1.0
 #pragma once
+#include <algorithm>
 #include <array>
+#include <memory>
 #include <ostream>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 #include "tser/varint_encoding.hpp"
 #include "tser/base64_encoding.hpp"
+//define TSER_ENABLE_STATS to let every BinaryArchive collect statistics about growth, bytes and allocations
+#ifdef TSER_ENABLE_STATS
+#include <chrono>
+#include <map>
+#define TSER_STATS(...) __VA_ARGS__
+#else
+#define TSER_STATS(...)
+#endif
 
 namespace tser{
     //implementation details for C++20 is_detected
     namespace detail {
-        struct ns {
-            ~ns() = delete;
-            ns(ns const&) = delete;
-        };
-        template <class Default, class AlwaysVoid, template<class...> class Op, class... Args>
-        struct detector {
-            using value_t = std::false_type;
-            using type = Default;
-        };
-        template <class Default, template<class...> class Op, class... Args>
-        struct detector<Default, std::void_t<Op<Args...>>, Op, Args...> {
-            using value_t = std::true_type;
-            using type = Op<Args...>;
-        };
+        //a variable template is cheaper to instantiate than the detector class of the TS, every probe costs one bool
+        template <class AlwaysVoid, template<class...> class Op, class... Args>
+        constexpr bool detector_v = false;
+        template <template<class...> class Op, class... Args>
+        constexpr bool detector_v<std::void_t<Op<Args...>>, Op, Args...> = true;
+        //only probes for a user defined operator if the deduced type is the serializable type itself
+        template <class OT, class Type, template<class...> class Op>
+        constexpr bool default_operator_v = false;
+        template <class Type, template<class...> class Op>
+        constexpr bool default_operator_v<Type, Type, Op> = !detector_v<void, Op, Type>;
         template<class T>
         struct is_array : std::is_array<T> {};
         template<template<typename, size_t> class TArray, typename T, size_t N>
@@ -37,12 +50,30 @@ namespace tser{
             return nargs;
         }
         constexpr size_t str_size(char const* c, size_t strSize = 1) {
-            for (; *c; ++c) ++strSize; return strSize;
+            for (; *c; ++c) ++strSize;
+            return strSize;
+        }
+        //the member name parsing is shared by all types with the same number of characters / members
+        template<size_t Size>
+        constexpr std::array<char, Size> member_name_data(char const* c) {
+            std::array<char, Size> chars{ '\0' };
+            for (size_t i = 0; *c; ++c, ++i) if (*c != ',' && *c != ' ') chars[i] = *c;
+            return chars;
+        }
+        template<size_t N, size_t Size>
+        constexpr std::array<const char*, N> member_names(const std::array<char, Size>& chars) {
+            std::array<const char*, N> out{ };
+            for (size_t i = 0, n = 0; n < N; ++i) {
+                while (chars[i] == '\0') ++i;
+                out[n++] = &chars[i];
+                while (chars[++i] != '\0');
+            }
+            return out;
         }
     }
     // we need a bunch of template metaprogramming for being able to differentiate between different types 
     template <template<class...> class Op, class... Args>
-    constexpr bool is_detected_v = detail::detector<detail::ns, void, Op, Args...>::value_t::value;
+    constexpr bool is_detected_v = detail::detector_v<void, Op, Args...>;
 
     class BinaryArchive;
     template<class T> using has_begin_t = decltype(*std::begin(std::declval<T>()));
@@ -57,10 +88,80 @@ namespace tser{
     template<class T> using has_mapped_t = typename T::mapped_type;
     template<class T> using has_custom_save_t = decltype(std::declval<T>().save(std::declval<BinaryArchive&>()));
     template<class T> using has_free_save_t = decltype(std::declval<const T&>() << std::declval<BinaryArchive&>());
+    template<class T> using has_capacity_t = decltype(std::declval<T>().capacity());
+    template<class T> using has_compare_t = decltype(std::declval<const T&>().compare(std::declval<const T&>()));
+    template<class T> using has_data_t = decltype(std::data(std::declval<T&>()));
+    template<class T> using has_resize_t = decltype(std::declval<T&>().resize(size_t()));
+    template<class T> using has_use_count_t = decltype(std::declval<T>().use_count());
     template<class T> constexpr bool is_container_v = is_detected_v<has_begin_t, T>;
     template<class T> constexpr bool is_tuple_v = is_detected_v<has_tuple_t, T>;
     template<class T> constexpr bool is_tser_t_v = is_detected_v<has_members_t, T>;
     template<class T> constexpr bool is_pointer_like_v = std::is_pointer_v<T> || is_detected_v<has_element_t, T> || is_detected_v<has_optional_t, T>;
+    template<class T> struct is_variant : std::false_type {};
+    template<class... Ts> struct is_variant<std::variant<Ts...>> : std::true_type {};
+    template<class T> constexpr bool is_variant_v = is_variant<T>::value;
+    //types can opt into bit packing with: static constexpr bool _packBits = true;
+    template<class T> using has_pack_bits_t = std::enable_if_t<T::_packBits>;
+    //containers of bools that only hand out proxy references, like std::vector<bool>
+    template<class T> using has_bit_proxy_t = std::enable_if_t<std::is_same_v<typename T::value_type, bool> && !std::is_reference_v<has_begin_t<T>>>;
+    //specialize value_range for an enum or integer type (or use tser::bounded) to store only the bits needed for [min, max]:
+    //template<> struct tser::value_range<Color> { static constexpr Color min = Color::Red, max = Color::Blue; };
+    //other types can map themselves to [min, max] with static uint64_t encode(const T&) and static T decode(uint64_t) functions
+    template<class T> struct value_range {};
+    template<class T> using has_value_range_t = decltype(value_range<T>::max);
+    template<class T> using has_range_codec_t = decltype(value_range<T>::decode(value_range<T>::encode(std::declval<const T&>())));
+    namespace detail {
+        template<class T>
+        constexpr uint64_t range_value(T t) {
+            if constexpr (std::is_enum_v<T>)
+                return static_cast<uint64_t>(static_cast<std::underlying_type_t<T>>(t));
+            else
+                return static_cast<uint64_t>(t);
+        }
+        template<class T> using range_t = std::decay_t<decltype(value_range<T>::max)>;
+        //distance of t to the min of its range
+        template<class T>
+        constexpr uint64_t range_offset(const T& t) {
+            if constexpr (is_detected_v<has_range_codec_t, T>)
+                return value_range<T>::encode(t) - range_value(value_range<T>::min);
+            else
+                return range_value(static_cast<range_t<T>>(t)) - range_value(value_range<T>::min);
+        }
+        template<class T>
+        constexpr T from_range_offset(uint64_t offset) {
+            using R = range_t<T>;
+            const uint64_t value = range_value(value_range<T>::min) + offset;
+            if constexpr (is_detected_v<has_range_codec_t, T>)
+                return value_range<T>::decode(value);
+            else if constexpr (std::is_enum_v<R>)
+                return T(static_cast<R>(static_cast<std::underlying_type_t<R>>(value)));
+            else
+                return T(static_cast<R>(value));
+        }
+        template<class T>
+        constexpr size_t range_bits() {
+            size_t bits = 0;
+            for (uint64_t span = range_value(value_range<T>::max) - range_value(value_range<T>::min); span != 0; span >>= 1)
+                ++bits;
+            return bits;
+        }
+        //bits a member takes in the bit header of types with _packBits:
+        //bools and presence flags of pointers/optionals take one, members with a value_range the bits needed for their range
+        template<class T>
+        constexpr size_t header_bits() {
+            if constexpr (is_detected_v<has_value_range_t, T>)
+                return range_bits<T>();
+            else if constexpr (std::is_same_v<T, bool> ||
+                (is_pointer_like_v<T> && !is_detected_v<has_free_save_t, T> && !is_detected_v<has_custom_save_t, T>))
+                return 1;
+            else
+                return 0;
+        }
+        template<class T> constexpr bool is_header_member_v = header_bits<T>() != 0 || is_detected_v<has_value_range_t, T>;
+        template<class Tuple> struct header_size;
+        template<class... Ts> struct header_size<std::tuple<Ts...>> : std::integral_constant<size_t, (header_bits<std::decay_t<Ts>>() + ... + 0) / 8
+            + ((header_bits<std::decay_t<Ts>>() + ... + 0) % 8 != 0)> {};
+    }
     //implementation of the recursive json printing
     template<typename T>
     constexpr inline decltype(auto) print(std::ostream& os, T&& val) {
@@ -88,52 +189,656 @@ namespace tser{
         else if constexpr (is_pointer_like_v<V>) {
             os << (val ? (os << (tser::print(os, *val)), "") : "null");
         }
+        else if constexpr (std::is_same_v<V, std::monostate>)
+            os << "null";
+        else if constexpr (is_variant_v<V>) {
+            if (val.valueless_by_exception())
+                os << "null";
+            else
+                std::visit([&](auto& alt) { tser::print(os, alt); }, val);
+        }
         else
             os << val;
         return "";
     }
-    //we have to implement the tuple < operator ourselves for recursive introspection
+    //three way comparison (<0, 0, >0) with the ordering of tser::less, each member is only compared once
     template<typename T>
-    constexpr inline bool less(const T& lhs, const T& rhs);
+    constexpr inline int compare(const T& lhs, const T& rhs);
+    template< class T, std::size_t... I>
+    constexpr inline int compare(const T& lhs, const T& rhs, std::index_sequence<I...>) {
+        int result = 0;
+        (void)(((result = compare(std::get<I>(lhs), std::get<I>(rhs))) == 0) && ...);
+        return result;
+    }
     template< class T, std::size_t... I>
-    constexpr inline bool less(const T& lhs, const T& rhs, std::index_sequence<I...>) {
-        bool isSmaller = false;
-        (void)((less(std::get<I>(lhs) , std::get<I>(rhs)) ? (static_cast<void>(isSmaller = true), false) : (less(std::get<I>(rhs), std::get<I>(lhs)) ? false : true)) &&...);
-        return isSmaller;
+    constexpr inline int compare_variant(const T& lhs, const T& rhs, std::index_sequence<I...>) {
+        int result = 0;
+        (void)((lhs.index() == I && ((result = compare(*std::get_if<I>(&lhs), *std::get_if<I>(&rhs))), true)) || ...);
+        return result;
     }
     template<typename T>
-    constexpr inline bool less(const T& lhs, const T& rhs) {
+    constexpr inline int compare(const T& lhs, const T& rhs) {
         if constexpr (is_tser_t_v<T>)
-            return less(lhs.members(), rhs.members());
+            return compare(lhs.members(), rhs.members());
+        else if constexpr (is_detected_v<has_compare_t, T>) {
+            const auto result = lhs.compare(rhs);
+            return (result > 0) - (result < 0);
+        }
+        else if constexpr (is_container_v<T>) {
+            using VT = std::decay_t<decltype(*std::begin(lhs))>;
+            //containers with operator< are ordered lexicographically, the others by size first
+            if constexpr (!is_detected_v<has_smaller_t, T>)
+                if (lhs.size() != rhs.size())
+                    return lhs.size() < rhs.size() ? -1 : 1;
+            if constexpr (is_detected_v<has_data_t, T> && (std::is_same_v<VT, unsigned char> || std::is_same_v<VT, std::byte>)) {
+                const size_t lSize = std::size(lhs), rSize = std::size(rhs), minSize = std::min(lSize, rSize);
+                const int result = minSize == 0 ? 0 : std::memcmp(std::data(lhs), std::data(rhs), minSize);
+                return result != 0 ? (result > 0) - (result < 0) : (lSize > rSize) - (lSize < rSize);
+            }
+            else {
+                auto l = std::begin(lhs), r = std::begin(rhs);
+                for (const auto lEnd = std::end(lhs), rEnd = std::end(rhs); l != lEnd && r != rEnd; ++l, ++r)
+                    if (const int result = compare(*l, *r); result != 0)
+                        return result;
+                return (l != std::end(lhs)) - (r != std::end(rhs));
+            }
+        }
         else if constexpr (is_tuple_v<T>)
-            return less(lhs, rhs, std::make_index_sequence<std::tuple_size_v<T>>());
-        else if constexpr (is_container_v<T> && !tser::is_detected_v<tser::has_smaller_t, T>) {
-            if (lhs.size() != rhs.size())
-                return lhs.size() < rhs.size();
-            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+            return compare(lhs, rhs, std::make_index_sequence<std::tuple_size_v<T>>());
+        else if constexpr (is_detected_v<has_optional_t, T>)
+            return lhs ? (rhs ? compare(*lhs, *rhs) : 1) : (rhs ? -1 : 0);
+        else if constexpr (is_variant_v<T>) {
+            //ordered by the index of the alternative first, valueless variants (variant_npos) order first like with std::variant
+            if (lhs.index() != rhs.index())
+                return lhs.index() + 1 < rhs.index() + 1 ? -1 : 1;
+            return compare_variant(lhs, rhs, std::make_index_sequence<std::variant_size_v<T>>());
         }
+        else if constexpr (std::is_enum_v<T>)
+            return compare(static_cast<std::underlying_type_t<T>>(lhs), static_cast<std::underlying_type_t<T>>(rhs));
+        else
+            return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+    }
+    template<typename T>
+    constexpr inline bool less(const T& lhs, const T& rhs) {
+        if constexpr (is_tser_t_v<T> || is_tuple_v<T> || is_container_v<T> || is_variant_v<T>)
+            return compare(lhs, rhs) < 0;
         else if constexpr (std::is_enum_v<T>)
             return static_cast<std::underlying_type_t<T>>(lhs) < static_cast<std::underlying_type_t<T>>(rhs);
         else
             return lhs < rhs;
     }
+    //an integer or enum member that is known to stay within [Min, Max], e.g. tser::bounded<uint32_t, 0, 1000> or tser::bounded<Color, Color::Red, Color::Blue>
+    template<typename T, T Min, T Max>
+    struct bounded {
+        static_assert(!less(Max, Min), "Min has to be smaller than Max");
+        T value = Min;
+        constexpr bounded() = default;
+        constexpr bounded(T val) : value(val) {}
+        //comparisons use the built-in operators of T through this conversion
+        constexpr operator T() const { return value; }
+        friend std::ostream& operator<<(std::ostream& os, const bounded& b) { print(os, b.value); return os; }
+    };
+    template<typename T, T Min, T Max>
+    struct value_range<bounded<T, Min, Max>> { static constexpr T min = Min, max = Max; };
+    //lossy fixed point encoding of a float/double in [Min, Max] with Scale steps per unit, values outside of the range are clamped
+    //e.g. tser::quantized<float, -1000, 1000, 1000> has millimeter precision and takes 21 bits
+    template<typename T, long long Min, long long Max, long long Scale>
+    struct quantized {
+        static_assert(std::is_floating_point_v<T> && Min < Max && Scale > 0, "quantized needs a floating point type and a valid range");
+        T value = T(0);
+        constexpr quantized() = default;
+        constexpr quantized(T val) : value(val) {}
+        constexpr operator T() const { return value; }
+    };
+    template<typename T, long long Min, long long Max, long long Scale>
+    struct value_range<quantized<T, Min, Max, Scale>> {
+        static constexpr uint64_t min = 0, max = static_cast<uint64_t>(Max - Min) * static_cast<uint64_t>(Scale);
+        static constexpr uint64_t encode(const quantized<T, Min, Max, Scale>& q) {
+            const double steps = (static_cast<double>(q.value) - static_cast<double>(Min)) * static_cast<double>(Scale);
+            //also maps NaN to min
+            return steps > 0 ? (steps >= static_cast<double>(max) ? max : static_cast<uint64_t>(steps + 0.5)) : 0;
+        }
+        static constexpr quantized<T, Min, Max, Scale> decode(uint64_t steps) {
+            return static_cast<T>(static_cast<double>(steps) / static_cast<double>(Scale) + static_cast<double>(Min));
+        }
+    };
 
+    namespace detail {
+        //an open checked frame (see crc32c.hpp), advance is called once the write position reaches end or before a read passes it
+        struct FrameCheck { bool (*advance)(FrameCheck&, const char* data, size_t position); size_t end; };
+    }
+    //upper bound of the serialized size of types without dynamic size, 0 if the size is dynamic (containers, custom save functions)
+    template<typename T>
+    constexpr size_t max_serialized_size();
+    namespace detail {
+        //SIZE_MAX if the member has a dynamic size, bools and ranged values of bit packed types only take space in the header
+        template<typename M, bool Packed>
+        constexpr size_t member_max_size() {
+            if constexpr (Packed && is_header_member_v<M> && !is_pointer_like_v<M>)
+                return 0;
+            else if constexpr (Packed && is_header_member_v<M>) {
+                constexpr size_t size = max_serialized_size<std::decay_t<decltype(*std::declval<M&>())>>();
+                return size == 0 ? SIZE_MAX : size;
+            }
+            else {
+                constexpr size_t size = max_serialized_size<M>();
+                return size == 0 ? SIZE_MAX : size;
+            }
+        }
+        template<typename Tuple, bool Packed = false, size_t... I>
+        constexpr size_t max_serialized_size_sum(std::index_sequence<I...>) {
+            const size_t sizes[] = { size_t(0), member_max_size<std::decay_t<std::tuple_element_t<I, Tuple>>, Packed>()... };
+            size_t sum = 0;
+            if constexpr (Packed)
+                sum = header_size<Tuple>::value;
+            for (size_t i = 1; i < sizeof...(I) + 1; ++i)
+                if (sizes[i] == SIZE_MAX)
+                    return 0;
+                else
+                    sum += sizes[i];
+            return sum;
+        }
+    }
+    namespace detail {
+        //varint index (one past the alternatives for valueless variants) and the largest alternative
+        template<typename T, size_t... I>
+        constexpr size_t max_variant_size(std::index_sequence<I...>) {
+            const size_t sizes[] = { max_serialized_size<std::variant_alternative_t<I, T>>()... };
+            size_t size = 1;
+            for (size_t index = sizeof...(I); index >= 128; index >>= 7)
+                ++size;
+            size_t maxSize = 0;
+            for (size_t alternativeSize : sizes)
+                if (alternativeSize == 0)
+                    return 0;
+                else
+                    maxSize = std::max(maxSize, alternativeSize);
+            return size + maxSize;
+        }
+    }
+    template<typename T>
+    constexpr size_t max_serialized_size() {
+        if constexpr (is_detected_v<has_free_save_t, T> || is_detected_v<has_custom_save_t, T>)
+            return 0;
+        else if constexpr (is_tser_t_v<T>) {
+            using Tuple = std::decay_t<decltype(std::declval<T&>().members())>;
+            return detail::max_serialized_size_sum<Tuple, is_detected_v<has_pack_bits_t, T>>(std::make_index_sequence<std::tuple_size_v<Tuple>>());
+        }
+        else if constexpr (is_container_v<T> && detail::is_array<T>::value) {
+            using VT = std::decay_t<decltype(*std::begin(std::declval<T&>()))>;
+            return max_serialized_size<VT>() * (sizeof(T) / sizeof(VT));
+        }
+        else if constexpr (is_tuple_v<T>)
+            return detail::max_serialized_size_sum<T>(std::make_index_sequence<std::tuple_size_v<T>>());
+        else if constexpr (is_pointer_like_v<T>) {
+            constexpr size_t inner = max_serialized_size<std::decay_t<decltype(*std::declval<T&>())>>();
+            return inner == 0 ? 0 : 1 + inner;
+        }
+        else if constexpr (is_container_v<T>)
+            return 0;
+        else if constexpr (is_variant_v<T>)
+            return detail::max_variant_size<T>(std::make_index_sequence<std::variant_size_v<T>>());
+        else if constexpr (is_detected_v<has_value_range_t, T>)
+            return (detail::range_bits<T>() + 7) / 8;
+        else if constexpr (std::is_integral_v<T> && sizeof(T) > 2)
+            return (sizeof(T) * 8 + 6) / 7;
+        else
+            return sizeof(T);
+    }
+    namespace detail {
+        //types whose serialized representation is exactly their object representation (if has_contiguous_layout holds as well)
+        //leaves that are memcpy'd and tser types whose members are such types without any padding in between
+        template<typename T>
+        constexpr bool is_trivially_serializable();
+        template<class T, class Tuple> struct has_trivial_members : std::false_type {};
+        template<class T, class... Ts> struct has_trivial_members<T, std::tuple<Ts...>> :
+            std::bool_constant<(sizeof(Ts) + ... + 0) == sizeof(T) && (is_trivially_serializable<std::decay_t<Ts>>() && ...)> {};
+        template<typename T>
+        constexpr bool is_trivially_serializable() {
+            if constexpr (!std::is_trivially_copyable_v<T> || is_detected_v<has_free_save_t, T> || is_detected_v<has_custom_save_t, T>
+                || is_detected_v<has_value_range_t, T> || is_detected_v<has_pack_bits_t, T> || is_variant_v<T>)
+                return false;
+            else if constexpr (is_tser_t_v<T>)
+                return std::is_default_constructible_v<T> && has_trivial_members<T, std::decay_t<decltype(std::declval<T&>().members())>>::value;
+            else if constexpr (is_container_v<T>)
+                return is_array<T>::value && is_trivially_serializable<std::decay_t<decltype(*std::begin(std::declval<T&>()))>>();
+            else if constexpr (is_tuple_v<T> || is_pointer_like_v<T>)
+                return false;
+            else
+                return !std::is_integral_v<T> || sizeof(T) <= 2;
+        }
+        //members() has to list the members in declaration order, this can only be checked at runtime (once per type)
+        template<typename T>
+        bool has_contiguous_layout() {
+            if constexpr (is_tser_t_v<T>) {
+                static const bool contiguous = [] {
+                    T t{};
+                    const char* const base = reinterpret_cast<const char*>(std::addressof(t));
+                    size_t offset = 0;
+                    bool inOrder = true;
+                    auto checkMember = [&](auto& mVal) {
+                        inOrder = inOrder && reinterpret_cast<const char*>(std::addressof(mVal)) == base + offset
+                            && has_contiguous_layout<std::decay_t<decltype(mVal)>>();
+                        offset += sizeof(mVal);
+                    };
+                    std::apply([&](auto& ... mVal) { (checkMember(mVal), ...); }, t.members());
+                    return inOrder;
+                }();
+                return contiguous;
+            }
+            else if constexpr (is_container_v<T>)
+                return has_contiguous_layout<std::decay_t<decltype(*std::begin(std::declval<T&>()))>>();
+            else
+                return true;
+        }
+        //members with a fixed maximum size that can be written without a capacity check of their own
+        template<typename T>
+        constexpr bool is_fixed_width_v = is_trivially_serializable<T>() || (!is_container_v<T> && !is_tuple_v<T> && !is_pointer_like_v<T>
+            && !is_tser_t_v<T> && !is_detected_v<has_free_save_t, T> && !is_detected_v<has_custom_save_t, T> && !is_detected_v<has_value_range_t, T> && !is_variant_v<T>);
+        //size of the run of fixed width members that starts at every member (0 for other members)
+        template<class Tuple> struct fixed_runs;
+        template<class... Ts> struct fixed_runs<std::tuple<Ts...>> {
+            static constexpr std::array<size_t, sizeof...(Ts)> sizes = [] {
+                const bool fixed[] = { is_fixed_width_v<std::decay_t<Ts>>..., false };
+                const size_t memberSizes[] = { max_serialized_size<std::decay_t<Ts>>()..., 0 };
+                std::array<size_t, sizeof...(Ts)> runs{};
+                for (size_t i = sizeof...(Ts); i-- > 0;)
+                    runs[i] = fixed[i] ? memberSizes[i] + (fixed[i + 1] ? runs[i + 1] : 0) : 0;
+                return runs;
+            }();
+        };
+        //contiguous containers of trivially serializable types are saved and loaded with a single memcpy
+        template<typename T, typename VT = std::decay_t<decltype(*std::begin(std::declval<T&>()))>>
+        constexpr bool is_bulk_container_v = is_detected_v<has_data_t, T> && (is_array<T>::value || is_detected_v<has_resize_t, T>)
+            && is_trivially_serializable<VT>() && !std::is_same_v<VT, bool>;
+    }
+#ifdef TSER_ENABLE_STATS
+    struct ArchiveStats {
+        //bytes written/read by a member of a tser type (including its nested members), the time is only measured with enable_stats_timing()
+        struct MemberStats { size_t bytesWritten = 0, bytesRead = 0; uint64_t saveNanoseconds = 0, loadNanoseconds = 0; };
+        //bytes written/read by tser types (including their nested members) and how often they were saved/loaded
+        //the members of bit packed types share their header, so they aren't broken down
+        struct TypeStats {
+            size_t bytesWritten = 0, bytesRead = 0, saved = 0, loaded = 0;
+            uint64_t saveNanoseconds = 0, loadNanoseconds = 0;
+            std::map<std::string_view, MemberStats> members;
+        };
+        size_t resizes = 0, bytesCopied = 0, bytesWritten = 0, bytesRead = 0, loadAllocations = 0;
+        std::map<std::string_view, TypeStats> types;
+    };
+    //text report: the totals, then every type with its members sorted by the bytes they wrote
+    inline void print_stats(std::ostream& os, const ArchiveStats& stats) {
+        auto percent = [](size_t part, size_t total) { return total == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(total); };
+        os << "archive: " << stats.bytesWritten << " bytes written, " << stats.bytesRead << " bytes read, " << stats.resizes << " resizes, "
+            << stats.bytesCopied << " bytes copied, " << stats.loadAllocations << " load allocations\n";
+        for (auto& [typeName, typeStats] : stats.types) {
+            os << typeName << ": " << typeStats.bytesWritten << " bytes written (" << typeStats.saved << " saved, "
+                << typeStats.saveNanoseconds << " ns), " << typeStats.bytesRead << " bytes read (" << typeStats.loaded << " loaded, "
+                << typeStats.loadNanoseconds << " ns)\n";
+            std::vector<const std::pair<const std::string_view, ArchiveStats::MemberStats>*> members;
+            for (auto& member : typeStats.members)
+                members.push_back(&member);
+            std::stable_sort(members.begin(), members.end(), [](auto* l, auto* r) { return l->second.bytesWritten > r->second.bytesWritten; });
+            for (auto* member : members)
+                os << "  " << member->first << ": " << member->second.bytesWritten << " bytes written ("
+                    << percent(member->second.bytesWritten, typeStats.bytesWritten) << "%, " << member->second.saveNanoseconds << " ns), "
+                    << member->second.bytesRead << " bytes read (" << percent(member->second.bytesRead, typeStats.bytesRead) << "%, "
+                    << member->second.loadNanoseconds << " ns)\n";
+        }
+    }
+    //the same report as json, e.g. to track size regressions in CI
+    inline void print_stats_json(std::ostream& os, const ArchiveStats& stats) {
+        os << "{\"bytesWritten\": " << stats.bytesWritten << ", \"bytesRead\": " << stats.bytesRead << ", \"resizes\": " << stats.resizes
+            << ", \"bytesCopied\": " << stats.bytesCopied << ", \"loadAllocations\": " << stats.loadAllocations << ", \"types\": {";
+        size_t i = 0;
+        for (auto& [typeName, typeStats] : stats.types) {
+            os << (i++ == 0 ? "" : ", ") << "\"" << typeName << "\": {\"bytesWritten\": " << typeStats.bytesWritten << ", \"bytesRead\": "
+                << typeStats.bytesRead << ", \"saved\": " << typeStats.saved << ", \"loaded\": " << typeStats.loaded << ", \"saveNanoseconds\": "
+                << typeStats.saveNanoseconds << ", \"loadNanoseconds\": " << typeStats.loadNanoseconds << ", \"members\": {";
+            size_t j = 0;
+            for (auto& [memberName, memberStats] : typeStats.members)
+                os << (j++ == 0 ? "" : ", ") << "\"" << memberName << "\": {\"bytesWritten\": " << memberStats.bytesWritten << ", \"bytesRead\": "
+                    << memberStats.bytesRead << ", \"saveNanoseconds\": " << memberStats.saveNanoseconds << ", \"loadNanoseconds\": "
+                    << memberStats.loadNanoseconds << "}";
+            os << "}}";
+        }
+        os << "}}\n";
+    }
+#endif
+    //the buffer grows to max(minCapacity, requiredSize * growthFactor), the first allocation happens on the first write
+    struct GrowthPolicy {
+        size_t minCapacity = 64;
+        double growthFactor = 2.0;
+    };
+    namespace detail {
+        //strings of an archive in string dictionary mode (see BinaryArchive::use_string_dictionary)
+        struct StringDictionary {
+            bool enabled = false;
+            //writer: index + 1 of every written string
+            std::unordered_map<std::string, size_t> indices;
+            std::string lookupKey;
+            //reader: offset and size of every read string in the buffer
+            std::vector<std::pair<size_t, size_t>> entries;
+            void clear() {
+                indices.clear();
+                entries.clear();
+            }
+            //forgets the strings written after the first count ones, e.g. when a save is rolled back
+            void truncate(size_t count) {
+                for (auto it = indices.begin(); it != indices.end();)
+                    it = it->second > count ? indices.erase(it) : std::next(it);
+            }
+        };
+    }
     class BinaryArchive {
-        std::string m_bytes = std::string(1024, '\0');
-        size_t m_bufferSize = 0, m_readOffset = 0;
+        //the owned buffer is not zero initialized, m_data either points to it or to a caller provided buffer
+        std::unique_ptr<char[]> m_storage;
+        char* m_data = nullptr;
+        size_t m_capacity = 0, m_bufferSize = 0, m_readOffset = 0;
+        GrowthPolicy m_growthPolicy;
+        detail::FrameCheck* m_frameCheck = nullptr;
+        size_t m_checkEnd = SIZE_MAX;
+        bool m_heapFallback = true, m_overflowed = false;
+        detail::StringDictionary m_dictionary;
+        template<size_t N> friend class StaticArchive;
+        TSER_STATS(ArchiveStats m_stats; bool m_statsTiming = false;)
+#ifdef TSER_ENABLE_STATS
+        //0 if the time isn't measured
+        uint64_t stats_now() const {
+            using namespace std::chrono;
+            return m_statsTiming ? static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count()) : 0;
+        }
+        void record_member(ArchiveStats::TypeStats& typeStats, const char* name, size_t bytes, uint64_t start, bool saved) {
+            auto& memberStats = typeStats.members[name];
+            const uint64_t nanoseconds = start != 0 ? stats_now() - start : 0;
+            (saved ? memberStats.bytesWritten : memberStats.bytesRead) += bytes;
+            (saved ? memberStats.saveNanoseconds : memberStats.loadNanoseconds) += nanoseconds;
+        }
+        //trivially serializable types are copied at once, their members are attributed their size
+        template<typename T, size_t... I>
+        void record_trivial_members(bool saved, std::index_sequence<I...>) {
+            using Tuple = std::decay_t<decltype(std::declval<T&>().members())>;
+            auto& typeStats = m_stats.types[T::_typeName];
+            (record_member(typeStats, T::_memberNames[I], sizeof(std::decay_t<std::tuple_element_t<I, Tuple>>), 0, saved), ...);
+        }
+#endif
+        bool check_frame(size_t position) {
+            const bool ok = m_frameCheck->advance(*m_frameCheck, m_data, position);
+            m_checkEnd = m_frameCheck->end;
+            return ok;
+        }
+        template<typename T>
+        static size_t capacity_of(const T& t) {
+            if constexpr (is_detected_v<has_capacity_t, T>)
+                return t.capacity();
+            else
+                return t.size();
+        }
+        bool grow(size_t requiredSize) {
+            const auto grownSize = static_cast<size_t>(static_cast<double>(requiredSize) * m_growthPolicy.growthFactor);
+            return reallocate(std::max({ requiredSize, grownSize, m_growthPolicy.minCapacity }));
+        }
+        //every run of consecutive fixed width members only needs a single capacity check
+        template<typename T>
+        void save_members(const T& t) {
+            constexpr auto& runs = detail::fixed_runs<std::decay_t<decltype(t.members())>>::sizes;
+            size_t index = 0;
+            bool reserved = false;
+            TSER_STATS(auto& typeStats = m_stats.types[T::_typeName];)
+            auto saveMember = [&](auto& mVal) {
+                const size_t i = index++;
+                TSER_STATS(const size_t offset = m_bufferSize; const uint64_t start = stats_now();)
+                if constexpr (detail::is_fixed_width_v<std::decay_t<decltype(mVal)>>) {
+                    //the run is reserved with its worst case size, a buffer that can't grow falls back to writing member by member
+                    if (i == 0 || runs[i - 1] == 0) {
+                        if (m_bufferSize >= m_checkEnd)
+                            check_frame(m_bufferSize);
+                        reserved = m_bufferSize + runs[i] <= m_capacity || (m_heapFallback && grow(m_bufferSize + runs[i]));
+                    }
+                    if (reserved)
+                        save_fixed(mVal);
+                    else
+                        save(mVal);
+                }
+                else
+                    save(mVal);
+                TSER_STATS(record_member(typeStats, T::_memberNames[i], m_bufferSize - offset, start, true);)
+            };
+            std::apply([&](auto& ... mVal) { (saveMember(mVal), ...); }, t.members());
+        }
+        template<bool Reload, typename T>
+        void load_members(T& t) {
+            TSER_STATS(auto& typeStats = m_stats.types[T::_typeName]; size_t index = 0;)
+            auto loadMember = [&](auto& mVal) {
+                TSER_STATS(const size_t offset = m_readOffset; const uint64_t start = stats_now();)
+                if constexpr (Reload)
+                    reload(mVal);
+                else
+                    load(mVal);
+                TSER_STATS(record_member(typeStats, T::_memberNames[index++], m_readOffset - offset, start, false);)
+            };
+            std::apply([&](auto& ... mVal) { (loadMember(mVal), ...); }, t.members());
+        }
+        //the caller made sure that max_serialized_size<T>() bytes fit into the buffer
+        template<typename T>
+        void save_fixed(const T& t) {
+            TSER_STATS(const size_t offset = m_bufferSize;)
+            if constexpr (is_tser_t_v<T> || is_container_v<T>) {
+                if (!detail::has_contiguous_layout<T>())
+                    return save(t);
+                std::memcpy(m_data + m_bufferSize, std::addressof(t), sizeof(T));
+                m_bufferSize += sizeof(T);
+            }
+            else if constexpr (std::is_integral_v<T> && sizeof(T) > 2)
+                m_bufferSize += encode_varint(t, m_data + m_bufferSize);
+            else {
+                std::memcpy(m_data + m_bufferSize, std::addressof(t), sizeof(T));
+                m_bufferSize += sizeof(T);
+            }
+            TSER_STATS(m_stats.bytesWritten += m_bufferSize - offset;)
+        }
+        //loads the pointee of a pointer/optional whose presence flag was already read
+        template<typename T>
+        void load_pointee(T& t, bool hasValue) {
+            if constexpr (std::is_pointer_v<T>) {
+                t = hasValue ? (TSER_STATS(++m_stats.loadAllocations,) t = new std::remove_pointer_t<T>(), load(*t), t) : nullptr;
+            }
+            else if constexpr (is_detected_v<has_optional_t, T>)
+                t = hasValue ? T(load<typename T::value_type>()) : T();
+            else { //smart pointer
+                has_element_t<T>* ptr = nullptr;
+                load_pointee(ptr, hasValue);
+                t = T(ptr);
+            }
+        }
+        //bit header with all bools, presence flags and ranged values, followed by the remaining members and the present pointees
+        template<typename Tuple>
+        void save_bit_packed(const Tuple& members) {
+            std::array<unsigned char, detail::header_size<std::decay_t<Tuple>>::value> header{};
+            size_t bit = 0;
+            auto writeHeader = [&](auto& mVal) {
+                using M = std::decay_t<decltype(mVal)>;
+                uint64_t value = 0;
+                if constexpr (is_detected_v<has_value_range_t, M>)
+                    value = detail::range_offset(mVal);
+                else if constexpr (detail::is_header_member_v<M>)
+                    value = static_cast<bool>(mVal);
+                for (size_t i = 0; i < detail::header_bits<M>(); ++i, ++bit)
+                    header[bit / 8] |= static_cast<unsigned char>(((value >> i) & 1u) << (bit % 8));
+            };
+            auto saveValue = [&](auto& mVal) {
+                using M = std::decay_t<decltype(mVal)>;
+                if constexpr (!detail::is_header_member_v<M>)
+                    save(mVal);
+                else if constexpr (is_pointer_like_v<M>) {
+                    if (mVal)
+                        save(*mVal);
+                }
+            };
+            std::apply([&](auto& ... mVal) { (writeHeader(mVal), ...); }, members);
+            save(header);
+            std::apply([&](auto& ... mVal) { (saveValue(mVal), ...); }, members);
+        }
+        //varint index of the alternative followed by its value, a compile time table of loaders constructs the alternative in place
+        template<typename V, size_t... I>
+        void save_variant(const V& v, std::index_sequence<I...>) {
+            using Saver = void(*)(BinaryArchive&, const V&);
+            static constexpr Saver savers[] = { [](BinaryArchive& ba, const V& val) { ba.save(*std::get_if<I>(&val)); }... };
+            //valueless variants are written as the index past the alternatives without a value
+            const size_t index = v.valueless_by_exception() ? sizeof...(I) : v.index();
+            save(index);
+            if (index < sizeof...(I))
+                savers[index](*this, v);
+        }
+        //an index past the alternatives leaves the variant unchanged
+        template<bool Reload, typename V, size_t... I>
+        void load_variant(V& v, std::index_sequence<I...>) {
+            using Loader = void(*)(BinaryArchive&, V&);
+            static constexpr Loader loaders[] = { [](BinaryArchive& ba, V& val) {
+                if (Reload && val.index() == I)
+                    ba.reload(*std::get_if<I>(&val));
+                else
+                    ba.load(val.template emplace<I>());
+            }... };
+            const size_t index = load<size_t>();
+            if (index < sizeof...(I))
+                loaders[index](*this, v);
+        }
+        //like load_pointee, but an existing pointee that isn't shared with other owners is reloaded in place
+        template<typename T>
+        void reload_pointee(T& t, bool hasValue) {
+            bool exclusive = static_cast<bool>(t);
+            if constexpr (is_detected_v<has_use_count_t, T>)
+                exclusive = exclusive && t.use_count() == 1;
+            if (hasValue && exclusive)
+                reload(*t);
+            else
+                load_pointee(t, hasValue);
+        }
+        template<bool Reload = false, typename Tuple>
+        void load_bit_packed(Tuple members) {
+            auto header = load<std::array<unsigned char, detail::header_size<std::decay_t<Tuple>>::value>>();
+            size_t bit = 0;
+            auto loadValue = [&](auto& mVal) {
+                using M = std::decay_t<decltype(mVal)>;
+                uint64_t value = 0;
+                for (size_t i = 0; i < detail::header_bits<M>(); ++i, ++bit)
+                    value |= static_cast<uint64_t>((header[bit / 8] >> (bit % 8)) & 1u) << i;
+                if constexpr (is_detected_v<has_value_range_t, M>)
+                    mVal = detail::from_range_offset<M>(value);
+                else if constexpr (std::is_same_v<M, bool>)
+                    mVal = value != 0;
+                else if constexpr (detail::is_header_member_v<M> && Reload)
+                    reload_pointee(mVal, value != 0);
+                else if constexpr (detail::is_header_member_v<M>)
+                    load_pointee(mVal, value != 0);
+                else if constexpr (Reload)
+                    reload(mVal);
+                else
+                    load(mVal);
+            };
+            std::apply([&](auto& ... mVal) { (loadValue(mVal), ...); }, members);
+        }
+        //in dictionary mode every string is prefixed by a varint: 0 for a new string or the index + 1 of a previous one
+        void save_string(std::string_view str) {
+            if (m_dictionary.enabled) {
+                m_dictionary.lookupKey.assign(str.data(), str.size());
+                auto [it, inserted] = m_dictionary.indices.try_emplace(m_dictionary.lookupKey, m_dictionary.indices.size() + 1);
+                save(inserted ? size_t(0) : it->second);
+                if (!inserted)
+                    return;
+            }
+            save(str.size());
+            save_bytes(str.data(), str.size());
+        }
+        //the returned view points into the buffer of the archive
+        std::string_view load_string() {
+            if (m_dictionary.enabled) {
+                if (const size_t index = load<size_t>(); index != 0) {
+                    if (index > m_dictionary.entries.size())
+                        return {};
+                    const auto [offset, size] = m_dictionary.entries[index - 1];
+                    return std::string_view(m_data + offset, size);
+                }
+            }
+            const size_t size = load<size_t>(), offset = m_readOffset;
+            if (offset + size > m_checkEnd && !check_frame(offset + size))
+                return {};
+            m_readOffset += size;
+            TSER_STATS(m_stats.bytesRead += size;)
+            if (m_dictionary.enabled)
+                m_dictionary.entries.emplace_back(offset, size);
+            return std::string_view(m_data + offset, size);
+        }
+        //without heap fallback the write that doesn't fit is dropped and the archive is marked as overflowed
+        bool reallocate(size_t capacity) {
+            if (!m_heapFallback)
+                return m_overflowed = true, false;
+            TSER_STATS(++m_stats.resizes; m_stats.bytesCopied += m_bufferSize;)
+            std::unique_ptr<char[]> storage(new char[capacity]);
+            if (m_bufferSize != 0)
+                std::memcpy(storage.get(), m_data, m_bufferSize);
+            m_storage = std::move(storage);
+            m_data = m_storage.get();
+            m_capacity = capacity;
+            return true;
+        }
     public:
-        explicit BinaryArchive(const size_t initialSize = 1024) : m_bytes(initialSize, '\0') {}
-        explicit BinaryArchive(std::string encodedStr) : m_bytes(decode_base64(encodedStr)), m_bufferSize(m_bytes.size()){}
+        explicit BinaryArchive(const size_t initialSize = 0) { reserve(initialSize); }
+        explicit BinaryArchive(std::string encodedStr) { initialize(decode_base64(encodedStr)); }
         template<typename T, std::enable_if_t<!std::is_integral_v<T>, int> = 0>
         explicit BinaryArchive(const T& t) { save(t); }
+        BinaryArchive(const BinaryArchive& other) : m_growthPolicy(other.m_growthPolicy) TSER_STATS(, m_stats(other.m_stats)) {
+            initialize(other.get_buffer());
+            m_readOffset = other.m_readOffset;
+            m_dictionary = other.m_dictionary;
+        }
+        BinaryArchive(BinaryArchive&& other) noexcept { *this = std::move(other); }
+        BinaryArchive& operator=(const BinaryArchive& other) {
+            if (this != &other) {
+                initialize(other.get_buffer());
+                m_readOffset = other.m_readOffset;
+                m_dictionary = other.m_dictionary;
+                m_growthPolicy = other.m_growthPolicy;
+                TSER_STATS(m_stats = other.m_stats;)
+            }
+            return *this;
+        }
+        BinaryArchive& operator=(BinaryArchive&& other) noexcept {
+            m_storage = std::move(other.m_storage);
+            m_data = std::exchange(other.m_data, nullptr);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_bufferSize = std::exchange(other.m_bufferSize, 0);
+            m_readOffset = std::exchange(other.m_readOffset, 0);
+            m_growthPolicy = other.m_growthPolicy;
+            m_heapFallback = std::exchange(other.m_heapFallback, true);
+            m_overflowed = std::exchange(other.m_overflowed, false);
+            m_dictionary = std::exchange(other.m_dictionary, detail::StringDictionary());
+            TSER_STATS(m_stats = std::move(other.m_stats);)
+            return *this;
+        }
         template<typename T>
         void save(const T& t){
             if constexpr (is_detected_v<has_free_save_t, T>)
                 operator<<(t,*this);
             else if constexpr (is_detected_v<has_custom_save_t, T>)
                 t.save(*this);
-            else if constexpr(is_tser_t_v<T>)
-                std::apply([&](auto& ... mVal) { (save(mVal), ...); }, t.members());
+            else if constexpr(is_tser_t_v<T>) {
+                TSER_STATS(const size_t offset = m_bufferSize; const uint64_t start = stats_now();)
+                if constexpr (detail::is_trivially_serializable<T>()) {
+                    if (detail::has_contiguous_layout<T>())
+                        save_bytes(std::addressof(t), sizeof(T));
+                    else
+                        std::apply([&](auto& ... mVal) { (save(mVal), ...); }, t.members());
+                    TSER_STATS(record_trivial_members<T>(true, std::make_index_sequence<T::_memberNames.size()>());)
+                }
+                else if constexpr (is_detected_v<has_pack_bits_t, T>)
+                    save_bit_packed(t.members());
+                else
+                    save_members(t);
+                TSER_STATS(auto& typeStats = m_stats.types[T::_typeName]; typeStats.bytesWritten += m_bufferSize - offset; ++typeStats.saved;
+                    typeStats.saveNanoseconds += start != 0 ? stats_now() - start : 0;)
+            }
             else if constexpr(is_tuple_v<T>)
                 std::apply([&](auto& ... tVal) { (save(tVal), ...); }, t);
             else if constexpr (is_pointer_like_v<T>) {
@@ -141,22 +846,78 @@ namespace tser{
                 if (t)
                     save(*t);
             }
+            else if constexpr (is_variant_v<T>)
+                save_variant(t, std::make_index_sequence<std::variant_size_v<T>>());
+            else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+                save_string(t);
+            else if constexpr (is_detected_v<has_bit_proxy_t, T>) {
+                //8 bools per byte, the first element is the lowest bit
+                const size_t size = t.size(), nBytes = (size + 7) / 8;
+                save(size);
+                if (m_bufferSize >= m_checkEnd)
+                    check_frame(m_bufferSize);
+                if (m_bufferSize + nBytes > m_capacity && !grow(m_bufferSize + nBytes))
+                    return;
+                auto it = std::begin(t);
+                for (size_t i = 0; i < size; i += 8) {
+                    unsigned char byte = 0;
+                    for (size_t bit = 0; bit < 8 && i + bit < size; ++bit, ++it)
+                        byte |= static_cast<unsigned char>(static_cast<bool>(*it) << bit);
+                    m_data[m_bufferSize++] = static_cast<char>(byte);
+                }
+                TSER_STATS(m_stats.bytesWritten += nBytes;)
+            }
             else if constexpr (is_container_v<T>) {
                 if constexpr (!detail::is_array<T>::value)
                     save(t.size());
+                if constexpr (detail::is_bulk_container_v<T>) {
+                    using VT = std::decay_t<decltype(*std::begin(t))>;
+                    if (detail::has_contiguous_layout<VT>())
+                        return save_bytes(std::data(t), std::size(t) * sizeof(VT));
+                }
                 for (auto& val : t)
                     save(val);
             }
+            else if constexpr (is_detected_v<has_value_range_t, T>) {
+                //outside of bit packed types ranged values take the minimal number of bytes
+                const uint64_t value = detail::range_offset(t);
+                std::array<unsigned char, (detail::range_bits<T>() + 7) / 8> bytes{};
+                for (size_t i = 0; i < bytes.size(); ++i)
+                    bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+                save(bytes);
+            }
             else
             {
-                if (m_bufferSize + sizeof(T) + sizeof(T) / 4 > m_bytes.size())
-                    m_bytes.resize((m_bufferSize + sizeof(T)) * 2);
+                if (m_bufferSize >= m_checkEnd)
+                    check_frame(m_bufferSize);
+                constexpr size_t maxSize = max_serialized_size<T>();
+                //a buffer that can't grow only needs room for the encoded size of the value
+                if (m_bufferSize + maxSize > m_capacity && !m_heapFallback) {
+                    std::array<char, maxSize> bytes;
+                    size_t size = sizeof(T);
+                    if constexpr (std::is_integral_v<T> && sizeof(T) > 2)
+                        size = encode_varint(t, bytes.data());
+                    else
+                        std::memcpy(bytes.data(), std::addressof(t), sizeof(T));
+                    if (m_bufferSize + size > m_capacity) {
+                        m_overflowed = true;
+                        return;
+                    }
+                    std::memcpy(m_data + m_bufferSize, bytes.data(), size);
+                    m_bufferSize += size;
+                    TSER_STATS(m_stats.bytesWritten += size;)
+                    return;
+                }
+                if (m_bufferSize + maxSize > m_capacity)
+                    grow(m_bufferSize + maxSize);
+                TSER_STATS(const size_t offset = m_bufferSize;)
                 if constexpr (std::is_integral_v<T> && sizeof(T) > 2)
-                    m_bufferSize += encode_varint(t, m_bytes.data() + m_bufferSize);
+                    m_bufferSize += encode_varint(t, m_data + m_bufferSize);
                 else {
-                    std::memcpy(m_bytes.data() + m_bufferSize, std::addressof(t), sizeof(T));
+                    std::memcpy(m_data + m_bufferSize, std::addressof(t), sizeof(T));
                     m_bufferSize += sizeof(T);
                 }
+                TSER_STATS(m_stats.bytesWritten += m_bufferSize - offset;)
             }
         }
         template<typename T>
@@ -166,47 +927,155 @@ namespace tser{
                 operator>>(t, *this);
             else if constexpr (is_detected_v<has_custom_save_t, T>)
                 t.load(*this);
-            else if constexpr (is_tser_t_v<T>)
-                std::apply([&](auto& ... mVal) { (load(mVal), ...); }, t.members());
+            else if constexpr (is_tser_t_v<T>) {
+                TSER_STATS(const size_t offset = m_readOffset; const uint64_t start = stats_now();)
+                if constexpr (detail::is_trivially_serializable<T>()) {
+                    if (detail::has_contiguous_layout<T>())
+                        load_bytes(std::addressof(t), sizeof(T));
+                    else
+                        std::apply([&](auto& ... mVal) { (load(mVal), ...); }, t.members());
+                    TSER_STATS(record_trivial_members<T>(false, std::make_index_sequence<T::_memberNames.size()>());)
+                }
+                else if constexpr (is_detected_v<has_pack_bits_t, T>)
+                    load_bit_packed(t.members());
+                else
+                    load_members<false>(t);
+                TSER_STATS(auto& typeStats = m_stats.types[T::_typeName]; typeStats.bytesRead += m_readOffset - offset; ++typeStats.loaded;
+                    typeStats.loadNanoseconds += start != 0 ? stats_now() - start : 0;)
+            }
             else if constexpr (is_tuple_v<V>)
                 std::apply([&](auto& ... tVal) { (load(tVal), ...); }, t);
-            else if constexpr (is_pointer_like_v<T>) {
-                if constexpr (std::is_pointer_v<T>) {
-                    t = load<bool>() ? (t = new std::remove_pointer_t<T>(), load(*t), t) : nullptr;
+            else if constexpr (is_pointer_like_v<T>)
+                load_pointee(t, load<bool>());
+            else if constexpr (is_variant_v<V>)
+                load_variant<false>(t, std::make_index_sequence<std::variant_size_v<V>>());
+            else if constexpr (std::is_same_v<V, std::string>) {
+                TSER_STATS(const size_t capacity = t.capacity();)
+                t.append(load_string());
+                TSER_STATS(m_stats.loadAllocations += t.capacity() != capacity;)
+            }
+            else if constexpr (std::is_same_v<V, std::string_view>)
+                t = load_string();
+            else if constexpr (is_detected_v<has_bit_proxy_t, V>) {
+                const size_t size = load<size_t>(), offset = t.size(), nBytes = (size + 7) / 8;
+                if (m_readOffset + nBytes > m_checkEnd && !check_frame(m_readOffset + nBytes))
+                    return;
+                t.resize(offset + size);
+                auto it = std::next(std::begin(t), static_cast<std::ptrdiff_t>(offset));
+                for (size_t i = 0; i < size; i += 8) {
+                    const auto byte = static_cast<unsigned char>(m_data[m_readOffset++]);
+                    for (size_t bit = 0; bit < 8 && i + bit < size; ++bit, ++it)
+                        *it = (byte >> bit) & 1u;
                 }
-                else if constexpr (is_detected_v<has_optional_t, T>)
-                    t = load<bool>() ? T(load<typename V::value_type>()) : T();
-                else //smart pointer
-                    t = T(load<has_element_t<V>*>());
+                TSER_STATS(m_stats.bytesRead += nBytes;)
             }
             else if constexpr (is_container_v<T>) {
+                if constexpr (detail::is_bulk_container_v<V>) {
+                    using VT = std::decay_t<decltype(*std::begin(t))>;
+                    if (detail::has_contiguous_layout<VT>()) {
+                        if constexpr (detail::is_array<V>::value)
+                            load_bytes(std::data(t), std::size(t) * sizeof(VT));
+                        else {
+                            const size_t size = load<size_t>(), offset = t.size();
+                            TSER_STATS(m_stats.loadAllocations += offset + size > capacity_of(t);)
+                            t.resize(offset + size);
+                            load_bytes(std::data(t) + offset, size * sizeof(VT));
+                        }
+                        return;
+                    }
+                }
                 if constexpr (!detail::is_array<T>::value) {
                     const auto size = load<decltype(t.size())>();
                     using VT = typename V::value_type;
-                    for (size_t i = 0; i < size; ++i)
+                    for (size_t i = 0; i < size; ++i) {
+                        TSER_STATS(const size_t capacity = capacity_of(t);)
                         if constexpr (!is_detected_v<has_mapped_t, V>)
                             t.insert(t.end(), load<VT>());
                         else //we have to special case map, because of the const key
                             t.emplace(VT{ load<typename V::key_type>(), load<typename V::mapped_type>() });
+                        //node based containers allocate on every insert, contiguous ones when their capacity changes
+                        TSER_STATS(m_stats.loadAllocations += capacity_of(t) != capacity;)
+                    }
                 }
                 else {
                     for (auto& val : t)
                         load(val);
                 }
             }
+            else if constexpr (is_detected_v<has_value_range_t, V>) {
+                const auto bytes = load<std::array<unsigned char, (detail::range_bits<V>() + 7) / 8>>();
+                uint64_t value = 0;
+                for (size_t i = 0; i < bytes.size(); ++i)
+                    value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+                t = detail::from_range_offset<V>(value);
+            }
             else {
+                if (m_readOffset + sizeof(T) + sizeof(T) / 4 > m_checkEnd && !check_frame(m_readOffset + sizeof(T) + sizeof(T) / 4)) {
+                    std::memset(std::addressof(t), 0, sizeof(T));
+                    return;
+                }
+                TSER_STATS(const size_t offset = m_readOffset;)
                 if constexpr (std::is_integral_v<T> && sizeof(T) > 2)
-                    m_readOffset += decode_varint(t, m_bytes.data() + m_readOffset);
+                    m_readOffset += decode_varint(t, m_data + m_readOffset);
                 else {
-                    std::memcpy(&t, m_bytes.data() + m_readOffset, sizeof(T));
+                    std::memcpy(&t, m_data + m_readOffset, sizeof(T));
                     m_readOffset += sizeof(T);
                 }
+                TSER_STATS(m_stats.bytesRead += m_readOffset - offset;)
             }
         }
         template<typename T>
         T load() {
             std::remove_const_t<T> t{}; load(t); return t;
         }
+        //overwrites t in place instead of appending to its containers like load does
+        //strings, vectors and their elements are resized and reloaded, so decoding into the same object again and again
+        //reuses their capacity and doesn't allocate once it is large enough (associative containers are cleared and refilled)
+        template<typename T>
+        void reload(T& t) {
+            using V = std::decay_t<T>;
+            if constexpr (is_detected_v<has_free_save_t, V> || is_detected_v<has_custom_save_t, T>)
+                load(t);
+            else if constexpr (is_tser_t_v<T>) {
+                if constexpr (detail::is_trivially_serializable<T>())
+                    load(t);
+                else {
+                    TSER_STATS(const size_t offset = m_readOffset; const uint64_t start = stats_now();)
+                    if constexpr (is_detected_v<has_pack_bits_t, T>)
+                        load_bit_packed<true>(t.members());
+                    else
+                        load_members<true>(t);
+                    TSER_STATS(auto& typeStats = m_stats.types[T::_typeName]; typeStats.bytesRead += m_readOffset - offset; ++typeStats.loaded;
+                        typeStats.loadNanoseconds += start != 0 ? stats_now() - start : 0;)
+                }
+            }
+            else if constexpr (is_tuple_v<V>)
+                std::apply([&](auto& ... tVal) { (reload(tVal), ...); }, t);
+            else if constexpr (is_pointer_like_v<T>)
+                reload_pointee(t, load<bool>());
+            else if constexpr (is_variant_v<V>)
+                load_variant<true>(t, std::make_index_sequence<std::variant_size_v<V>>());
+            else if constexpr (is_container_v<T> && detail::is_array<V>::value) {
+                for (auto& val : t)
+                    reload(val);
+            }
+            else if constexpr (is_container_v<T> && !std::is_same_v<V, std::string_view>) {
+                if constexpr (std::is_same_v<V, std::string> || detail::is_bulk_container_v<V> || is_detected_v<has_bit_proxy_t, V>
+                    || !is_detected_v<has_resize_t, V> || is_detected_v<has_mapped_t, V>) {
+                    t.clear();
+                    load(t);
+                }
+                else {
+                    TSER_STATS(const size_t capacity = capacity_of(t);)
+                    t.resize(load<decltype(t.size())>());
+                    TSER_STATS(m_stats.loadAllocations += capacity_of(t) != capacity;)
+                    for (auto& val : t)
+                        reload(val);
+                }
+            }
+            else
+                load(t);
+        }
         template<typename T>
         friend BinaryArchive& operator<<(BinaryArchive& ba, const T& t) {
             ba.save(t); return ba;
@@ -218,42 +1087,150 @@ namespace tser{
         void reset() {
             m_bufferSize = 0;
             m_readOffset = 0;
+            m_overflowed = false;
+            m_dictionary.clear();
         }
         void initialize(std::string_view str) {
-            m_bytes = str;
+            m_dictionary.clear();
+            if (str.size() > m_capacity) {
+                m_bufferSize = 0;
+                if (!reallocate(str.size()))
+                    return;
+            }
+            if (!str.empty())
+                std::memmove(m_data, str.data(), str.size());
             m_bufferSize = str.size();
             m_readOffset = 0;
         }
+        //resets the archive to size bytes (uninitialized) which the caller fills, e.g. when decompressing into the archive
+        //returns nullptr if the archive can't hold size bytes (see use_buffer)
+        char* initialize(size_t size) {
+            reset();
+            if (size > m_capacity && !reallocate(size))
+                return nullptr;
+            m_bufferSize = size;
+            return m_data;
+        }
+        //serialize directly into a caller provided buffer (e.g. a registered I/O ring buffer) without copying
+        //if the data doesn't fit, the archive falls back to its own heap storage (see uses_external_buffer())
+        //without heap fallback writes that don't fit are dropped and overflowed() is set instead
+        void use_buffer(char* buffer, size_t capacity, bool allowHeapFallback = true) {
+            reset();
+            m_storage.reset();
+            m_data = buffer;
+            m_capacity = capacity;
+            m_heapFallback = allowHeapFallback;
+        }
+        //raw bytes without a size prefix
+        void save_bytes(const void* data, size_t size) {
+            if (m_bufferSize >= m_checkEnd)
+                check_frame(m_bufferSize);
+            if (m_bufferSize + size > m_capacity && !grow(m_bufferSize + size))
+                return;
+            if (size != 0)
+                std::memcpy(m_data + m_bufferSize, data, size);
+            m_bufferSize += size;
+            TSER_STATS(m_stats.bytesWritten += size;)
+        }
+        void load_bytes(void* data, size_t size) {
+            if (m_readOffset + size > m_checkEnd && !check_frame(m_readOffset + size)) {
+                if (size != 0)
+                    std::memset(data, 0, size);
+                return;
+            }
+            if (size != 0)
+                std::memcpy(data, m_data + m_readOffset, size);
+            m_readOffset += size;
+            TSER_STATS(m_stats.bytesRead += size;)
+        }
+        //writes every distinct std::string/std::string_view only once and refers to it by index afterwards
+        //the writing and the reading archive both have to enable it, loaded string_views point into the archive buffer
+        void use_string_dictionary(bool enable = true) {
+            m_dictionary.clear();
+            m_dictionary.enabled = enable;
+        }
+        bool overflowed() const { return m_overflowed; }
+        bool uses_external_buffer() const { return m_data != nullptr && m_data != m_storage.get(); }
+        void reserve(size_t capacity) {
+            if (capacity > m_capacity)
+                reallocate(capacity);
+        }
+        size_t capacity() const { return m_capacity; }
+        void set_growth_policy(GrowthPolicy growthPolicy) { m_growthPolicy = growthPolicy; }
         std::string_view get_buffer() const {
-            return std::string_view(m_bytes.data(), m_bufferSize);
+            return std::string_view(m_data, m_bufferSize);
+        }
+        //raw access to the written bytes and the read position, e.g. for framing and checksums
+        char* data() { return m_data; }
+        size_t read_offset() const { return m_readOffset; }
+        //reading from the start again also restarts the string dictionary
+        void set_read_offset(size_t offset) {
+            if (offset == 0)
+                m_dictionary.entries.clear();
+            m_readOffset = offset;
+        }
+        //installs (or removes with nullptr) the checked frame that reads and writes report their progress to
+        void set_frame_check(detail::FrameCheck* frameCheck) {
+            m_frameCheck = frameCheck;
+            m_checkEnd = frameCheck ? frameCheck->end : SIZE_MAX;
         }
+        detail::FrameCheck* frame_check() const { return m_frameCheck; }
+#ifdef TSER_ENABLE_STATS
+        const ArchiveStats& stats() const { return m_stats; }
+        void reset_stats() { m_stats = ArchiveStats{}; }
+        //also measure the time spent saving/loading every tser type and member (two clock reads per member)
+        void enable_stats_timing(bool enable = true) { m_statsTiming = enable; }
+#endif
         friend std::ostream& operator<<(std::ostream& os, const BinaryArchive& ba) {
             return os << encode_base64(ba.get_buffer()) << '\n';
         }
     };
+    //a BinaryArchive over an inline buffer that never allocates, e.g. for latency critical paths
+    //save returns false (and rolls back the partially written object) if an object doesn't fit
+    template<size_t N>
+    class StaticArchive : public BinaryArchive {
+        std::array<char, N> m_inlineBuffer;
+    public:
+        StaticArchive() { use_buffer(m_inlineBuffer.data(), N, false); }
+        StaticArchive(const StaticArchive&) = delete;
+        StaticArchive& operator=(const StaticArchive&) = delete;
+        template<typename T>
+        bool save(const T& t) {
+            static_assert(max_serialized_size<T>() <= N, "the type doesn't fit into the StaticArchive");
+            const size_t offset = m_bufferSize, dictionarySize = m_dictionary.indices.size();
+            BinaryArchive::save(t);
+            if (!m_overflowed)
+                return true;
+            m_overflowed = false;
+            m_bufferSize = offset;
+            //strings of the rolled back object have to be written again by the next save
+            if (m_dictionary.indices.size() != dictionarySize)
+                m_dictionary.truncate(dictionarySize);
+            return false;
+        }
+        template<typename T>
+        friend StaticArchive& operator<<(StaticArchive& ba, const T& t) {
+            ba.save(t); return ba;
+        }
+    };
     template<class Base, typename Derived>
     std::conditional_t<std::is_const_v<Derived>, const Base, Base>& base(Derived* thisPtr) { return *thisPtr; }
     template<typename T>
     auto load(std::string_view encoded) { BinaryArchive ba(encoded); return ba.load<T>(); }
 }
 //this macro defines printing, serialisation and comparision operators (==,!=,<) for custom types
+//members() is a template, so the tuple of references is only instantiated in translation units that use the type
 #define DEFINE_SERIALIZABLE(Type, ...) \
-inline decltype(auto) members() const { return std::tie(__VA_ARGS__); } \
-inline decltype(auto) members() { return std::tie(__VA_ARGS__); }  \
-static constexpr std::array<char, tser::detail::str_size(#__VA_ARGS__)> _memberNameData = [](){ \
-std::array<char, tser::detail::str_size(#__VA_ARGS__)> chars{'\0'}; size_t _idx = 0; constexpr auto* ini(#__VA_ARGS__);  \
-for (char const* _c = ini; *_c; ++_c, ++_idx) if(*_c != ',' && *_c != ' ') chars[_idx] = *_c;  return chars;}(); \
+template<int = 0> decltype(auto) members() const { return std::tie(__VA_ARGS__); } \
+template<int = 0> decltype(auto) members() { return std::tie(__VA_ARGS__); }  \
+static constexpr auto _memberNameData = tser::detail::member_name_data<tser::detail::str_size(#__VA_ARGS__)>(#__VA_ARGS__); \
 static constexpr const char* _typeName = #Type; \
-static constexpr std::array<const char*, tser::detail::n_args(#__VA_ARGS__)> _memberNames = \
-[](){ std::array<const char*, tser::detail::n_args(#__VA_ARGS__)> out{ }; \
-for(size_t _i = 0, nArgs = 0; nArgs < tser::detail::n_args(#__VA_ARGS__) ; ++_i) { \
-while(Type::_memberNameData[_i] == '\0') _i++; out[nArgs++] = &Type::_memberNameData[_i]; \
-while(Type::_memberNameData[++_i] != '\0'); } return out;}();\
-template<typename OT, std::enable_if_t<std::is_same_v<OT,Type> && !tser::is_detected_v<tser::has_equal_t, OT>, int> = 0>\
+static constexpr auto _memberNames = tser::detail::member_names<tser::detail::n_args(#__VA_ARGS__)>(_memberNameData); \
+template<typename OT, std::enable_if_t<tser::detail::default_operator_v<OT, Type, tser::has_equal_t>, int> = 0>\
 friend bool operator==(const Type& lhs, const OT& rhs) { return lhs.members() == rhs.members(); }\
-template<typename OT, std::enable_if_t<std::is_same_v<OT,Type> && !tser::is_detected_v<tser::has_nequal_t, OT>, int> = 0>\
+template<typename OT, std::enable_if_t<tser::detail::default_operator_v<OT, Type, tser::has_nequal_t>, int> = 0>\
 friend bool operator!=(const Type& lhs, const OT& rhs) { return !(lhs == rhs); }\
-template<typename OT, std::enable_if_t<std::is_same_v<OT,Type> && !tser::is_detected_v<tser::has_smaller_t, OT>, int> = 0>\
-friend bool operator< (const OT& lhs, const OT& rhs) { return tser::less(lhs, rhs); } \
-template<typename OT, std::enable_if_t<std::is_same_v<OT,Type> && !tser::is_detected_v<tser::has_outstream_op_t, OT>, int> = 0>\
+template<typename OT, std::enable_if_t<tser::detail::default_operator_v<OT, Type, tser::has_smaller_t>, int> = 0>\
+friend bool operator< (const OT& lhs, const OT& rhs) { return tser::compare(lhs, rhs) < 0; } \
+template<typename OT, std::enable_if_t<tser::detail::default_operator_v<OT, Type, tser::has_outstream_op_t>, int> = 0>\
 friend std::ostream& operator<<(std::ostream& os, const OT& t) { tser::print(os, t); return os; }
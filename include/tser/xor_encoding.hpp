@@ -0,0 +1,188 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "tser/tser.hpp"
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+namespace tser {
+    //lossless XOR encoding of float/double series (see "Gorilla: A Fast, Scalable, In-Memory Time Series Database")
+    //every value is XORed with its predecessor: equal values take 1 bit, otherwise only the meaningful bits between the
+    //leading and trailing zeros are stored, reusing the previous window if they fit into it
+    namespace detail {
+        inline unsigned count_leading_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_clzll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+            unsigned long index;
+            _BitScanReverse64(&index, x);
+            return 63u - static_cast<unsigned>(index);
+#else
+            unsigned n = 0;
+            for (uint64_t mask = uint64_t(1) << 63; !(x & mask); mask >>= 1)
+                ++n;
+            return n;
+#endif
+        }
+        inline unsigned count_trailing_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+            unsigned long index;
+            _BitScanForward64(&index, x);
+            return static_cast<unsigned>(index);
+#else
+            unsigned n = 0;
+            for (; !(x & 1); x >>= 1)
+                ++n;
+            return n;
+#endif
+        }
+        //most significant bit first
+        class BitWriter {
+            std::string& m_out;
+            uint64_t m_bits = 0;
+            unsigned m_size = 0;
+        public:
+            explicit BitWriter(std::string& out) : m_out(out) {}
+            void write(uint64_t value, unsigned bits) {
+                if (bits > 32) {
+                    write(value >> 32, bits - 32);
+                    bits = 32;
+                }
+                m_bits = (m_bits << bits) | (value & ((uint64_t(1) << bits) - 1));
+                for (m_size += bits; m_size >= 8; m_size -= 8)
+                    m_out.push_back(static_cast<char>(m_bits >> (m_size - 8)));
+            }
+            void flush() {
+                if (m_size != 0)
+                    m_out.push_back(static_cast<char>(m_bits << (8 - m_size)));
+                m_size = 0;
+            }
+        };
+        class BitReader {
+            const unsigned char* m_in, * m_end;
+            uint64_t m_bits = 0;
+            unsigned m_size = 0;
+            bool m_overrun = false;
+        public:
+            BitReader(const char* in, size_t size) : m_in(reinterpret_cast<const unsigned char*>(in)), m_end(m_in + size) {}
+            uint64_t read(unsigned bits) {
+                if (bits > 32) {
+                    const uint64_t high = read(bits - 32);
+                    return high << 32 | read(32);
+                }
+                for (; m_size < bits; m_size += 8) {
+                    m_overrun |= m_in == m_end;
+                    m_bits = m_bits << 8 | (m_in != m_end ? *m_in++ : 0u);
+                }
+                m_size -= bits;
+                return (m_bits >> m_size) & ((uint64_t(1) << bits) - 1);
+            }
+            bool overrun() const { return m_overrun; }
+        };
+        template<typename T>
+        using float_bits_t = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+    }
+    template<typename T>
+    void encode_xor(const T* values, size_t count, std::string& out) {
+        static_assert(std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "only float and double are supported");
+        constexpr unsigned width = sizeof(T) * 8, lengthBits = sizeof(T) == 4 ? 5 : 6;
+        if (count == 0)
+            return;
+        out.reserve(out.size() + count * 2 + sizeof(T));
+        detail::BitWriter writer(out);
+        detail::float_bits_t<T> previous;
+        std::memcpy(&previous, values, sizeof(T));
+        writer.write(previous, width);
+        unsigned windowLeading = width, windowTrailing = 0;
+        for (size_t i = 1; i < count; ++i) {
+            detail::float_bits_t<T> current;
+            std::memcpy(&current, values + i, sizeof(T));
+            const uint64_t x = current ^ previous;
+            previous = current;
+            if (x == 0) {
+                writer.write(0, 1);
+                continue;
+            }
+            const unsigned leading = std::min(detail::count_leading_zeros(x) - (64 - width), 31u), trailing = detail::count_trailing_zeros(x);
+            if (leading >= windowLeading && trailing >= windowTrailing) {
+                writer.write(2, 2);
+                writer.write(x >> windowTrailing, width - windowLeading - windowTrailing);
+            }
+            else {
+                const unsigned length = width - leading - trailing;
+                writer.write(3, 2);
+                writer.write(leading, 5);
+                writer.write(length - 1, lengthBits);
+                writer.write(x >> trailing, length);
+                windowLeading = leading;
+                windowTrailing = trailing;
+            }
+        }
+        writer.flush();
+    }
+    //returns false if the input is too short for count values
+    template<typename T>
+    bool decode_xor(const char* in, size_t size, T* out, size_t count) {
+        static_assert(std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "only float and double are supported");
+        constexpr unsigned width = sizeof(T) * 8, lengthBits = sizeof(T) == 4 ? 5 : 6;
+        if (count == 0)
+            return true;
+        detail::BitReader reader(in, size);
+        auto previous = static_cast<detail::float_bits_t<T>>(reader.read(width));
+        std::memcpy(out, &previous, sizeof(T));
+        unsigned windowLeading = width, windowTrailing = 0;
+        for (size_t i = 1; i < count && !reader.overrun(); ++i) {
+            if (reader.read(1) != 0) {
+                if (reader.read(1) != 0) {
+                    windowLeading = static_cast<unsigned>(reader.read(5));
+                    windowTrailing = width - windowLeading - static_cast<unsigned>(reader.read(lengthBits)) - 1;
+                    //corrupted input can't describe more meaningful bits than the width
+                    if (windowTrailing >= width)
+                        return false;
+                }
+                if (windowLeading + windowTrailing >= width)
+                    return false;
+                previous ^= static_cast<detail::float_bits_t<T>>(reader.read(width - windowLeading - windowTrailing) << windowTrailing);
+            }
+            std::memcpy(out + i, &previous, sizeof(T));
+        }
+        return !reader.overrun();
+    }
+    //std::vector<float/double> that is XOR encoded in archives, e.g. for slowly changing sensor readings or prices
+    //format: varint count, varint byte size, encoded bits
+    template<typename T>
+    class xor_encoded : public std::vector<T> {
+    public:
+        using std::vector<T>::vector;
+        //the payload is written as raw bytes, so it never goes through the string dictionary
+        void save(BinaryArchive& ba) const {
+            static thread_local std::string encoded;
+            encoded.clear();
+            encode_xor(this->data(), this->size(), encoded);
+            ba.save(this->size());
+            ba.save(encoded.size());
+            ba.save_bytes(encoded.data(), encoded.size());
+        }
+        //decodes straight from the archive buffer, on malformed input the vector is cleared
+        void load(BinaryArchive& ba) {
+            const size_t count = ba.load<size_t>(), size = ba.load<size_t>(), offset = ba.read_offset();
+            const size_t available = ba.get_buffer().size() > offset ? ba.get_buffer().size() - offset : 0;
+            //every value takes at least one bit, so a corrupted count can't trigger a huge allocation
+            this->clear();
+            if (size <= available && count <= size * 8) {
+                this->resize(count);
+                if (!decode_xor(ba.data() + offset, size, this->data(), count))
+                    this->clear();
+            }
+            ba.set_read_offset(offset + std::min(size, available));
+        }
+    };
+}
@@ -2,13 +2,31 @@
 // SPDX-License-Identifier: BSL-1.0
 #include "gtest/gtest.h"
 #include "tser/tser.hpp"
+#include "tser/archive_pool.hpp"
+#include "tser/columnar.hpp"
+#include "tser/compression.hpp"
+#include "tser/crc32c.hpp"
+#include "tser/hash.hpp"
+#include "tser/patch.hpp"
+#include "tser/record_file.hpp"
+#include "tser/sort_key.hpp"
+#include "tser/stream_decoder.hpp"
+#include "tser/xor_encoding.hpp"
 #include "print_diff.hpp"
 
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <map>
 #include <numeric>
 #include <optional>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <variant>
 
 //if you need deep pointer comparisions you could grab this macro
 namespace tser::detail {
@@ -21,15 +39,13 @@ namespace tser::detail {
 }
 #define DEFINE_DEEP_POINTER_COMPARISION(Type)\
 friend bool operator==(const Type& lhs, const Type& rhs){ return tser::detail::compareTuples(lhs.members(), rhs.members(), std::make_index_sequence<std::tuple_size_v<decltype(lhs.members())>>{});}
-//if a complex type doesn't have a hash function and your too lazy to implement one, you could use this ugly hack
+//if a complex type doesn't have a hash function and your too lazy to implement one, you could use this macro
 #define DEFINE_HASHABLE(Type) \
 namespace std { \
         template<> \
         struct hash<Type> { \
             size_t operator()(const Type& t) const { \
-                tser::BinaryArchive bs(sizeof(Type) + 1); \
-                bs << t; \
-                return std::hash<std::string_view>()(bs.get_buffer()); \
+                return tser::hash<Type>()(t); \
         } \
     }; \
 }
@@ -304,6 +320,800 @@ TEST(binaryArchive, complexType)
     ASSERT_EQ(c, c2);
 }
 
+TEST(binaryArchive, growthPolicy)
+{
+    tser::BinaryArchive ba;
+    ASSERT_EQ(ba.capacity(), 0u);
+    ba.set_growth_policy(tser::GrowthPolicy{ 16, 1.5 });
+    ba.save('a');
+    ASSERT_EQ(ba.capacity(), 16u);
+    ba.save(std::string(100, 'b'));
+    ASSERT_GE(ba.capacity(), 102u);
+    ba.reserve(4096);
+    ASSERT_EQ(ba.capacity(), 4096u);
+    ASSERT_EQ(ba.load<char>(), 'a');
+    ASSERT_EQ(ba.load<std::string>(), std::string(100, 'b'));
+}
+
+TEST(binaryArchive, externalBuffer)
+{
+    std::array<char, 64> ringSlot{};
+    tser::BinaryArchive ba;
+    ba.use_buffer(ringSlot.data(), ringSlot.size());
+    ba << Point{ 1, 2 } << std::string("fits");
+    ASSERT_TRUE(ba.uses_external_buffer());
+    ASSERT_EQ(ba.get_buffer().data(), ringSlot.data());
+    ASSERT_EQ(ba.load<Point>(), (Point{ 1, 2 }));
+    //falls back to heap storage when the external buffer overflows
+    ba << std::string(100, 'x');
+    ASSERT_FALSE(ba.uses_external_buffer());
+    ASSERT_EQ(ba.load<std::string>(), "fits");
+    ASSERT_EQ(ba.load<std::string>(), std::string(100, 'x'));
+
+    tser::BinaryArchive copy(ba), moved(std::move(ba));
+    ASSERT_EQ(copy.get_buffer(), moved.get_buffer());
+    ASSERT_TRUE(ba.get_buffer().empty());
+    copy.reset();
+    ASSERT_EQ(copy.load<Point>(), (Point{ 1, 2 }));
+}
+
+TEST(staticArchive, saveAndLoad)
+{
+    static_assert(tser::max_serialized_size<Point>() == 10);
+    static_assert(tser::max_serialized_size<std::optional<Point>>() == 11);
+    static_assert(tser::max_serialized_size<std::array<Point, 4>>() == 40);
+    static_assert(tser::max_serialized_size<std::vector<int>>() == 0);
+    tser::StaticArchive<16> ba;
+    ASSERT_TRUE(ba.save(Point{ 1, 2 }));
+    ba << Object{ { 3, 4 }, 5 };
+    ASSERT_EQ(ba.capacity(), 16u);
+    ASSERT_TRUE(ba.uses_external_buffer());
+    ASSERT_EQ(ba.load<Point>(), (Point{ 1, 2 }));
+    ASSERT_EQ(ba.load<Object>(), (Object{ { 3, 4 }, 5 }));
+    //doesn't compile: ba.save(std::array<Point, 2>{});
+
+    //values fit into archives of exactly their maximum size
+    tser::StaticArchive<tser::max_serialized_size<double>()> doubles;
+    ASSERT_TRUE(doubles.save(1.0));
+    ASSERT_EQ(doubles.load<double>(), 1.0);
+    tser::StaticArchive<tser::max_serialized_size<float>()> floats;
+    ASSERT_TRUE(floats.save(1.0f));
+    tser::StaticArchive<tser::max_serialized_size<uint64_t>()> ints;
+    ASSERT_TRUE(ints.save(std::numeric_limits<uint64_t>::max()));
+    ASSERT_FALSE(ints.save(uint64_t(1)));
+    ASSERT_EQ(ints.load<uint64_t>(), std::numeric_limits<uint64_t>::max());
+    //varints only need their encoded size
+    tser::StaticArchive<tser::max_serialized_size<uint64_t>()> varints;
+    ASSERT_TRUE(varints.save(uint64_t(5)));
+    ASSERT_TRUE(varints.save(uint64_t(300)));
+    ASSERT_EQ(varints.load<uint64_t>(), 5u);
+    ASSERT_EQ(varints.load<uint64_t>(), 300u);
+}
+
+TEST(staticArchive, overflow)
+{
+    tser::StaticArchive<16> ba;
+    ASSERT_TRUE(ba.save(std::string("short")));
+    const auto written = ba.get_buffer().size();
+    ASSERT_FALSE(ba.save(std::string(20, 'x')));
+    ASSERT_EQ(ba.get_buffer().size(), written);
+    ASSERT_TRUE(ba.save(std::string("ok")));
+    ASSERT_EQ(ba.load<std::string>(), "short");
+    ASSERT_EQ(ba.load<std::string>(), "ok");
+
+    //reset clears the overflow of an archive without heap fallback
+    std::array<char, 4> buffer;
+    tser::BinaryArchive external;
+    external.use_buffer(buffer.data(), buffer.size(), false);
+    external.save(std::string(20, 'x'));
+    ASSERT_TRUE(external.overflowed());
+    external.reset();
+    ASSERT_FALSE(external.overflowed());
+    external.save(std::string("ok"));
+    ASSERT_FALSE(external.overflowed());
+    ASSERT_EQ(external.load<std::string>(), "ok");
+
+    //strings of a rolled back save aren't referenced by later saves in dictionary mode
+    tser::StaticArchive<80> dictionary;
+    dictionary.use_string_dictionary();
+    const std::string longString(60, 'l');
+    ASSERT_TRUE(dictionary.save(std::string("abc")));
+    ASSERT_FALSE(dictionary.save(std::vector<std::string>{ longString, longString + longString }));
+    ASSERT_TRUE(dictionary.save(longString));
+    ASSERT_TRUE(dictionary.save(longString));
+    ASSERT_EQ(dictionary.load<std::string>(), "abc");
+    ASSERT_EQ(dictionary.load<std::string>(), longString);
+    ASSERT_EQ(dictionary.load<std::string>(), longString);
+}
+
+struct FeatureFlags
+{
+    DEFINE_SERIALIZABLE(FeatureFlags, a, b, c, d, e, f, g, h, i, limit, origin, version, j)
+    static constexpr bool _packBits = true;
+    bool a = false, b = true, c = false, d = true, e = true, f = false, g = false, h = true, i = true;
+    std::optional<int> limit;
+    std::unique_ptr<Point> origin;
+    uint16_t version = 3;
+    bool j = true;
+    DEFINE_DEEP_POINTER_COMPARISION(FeatureFlags)
+};
+
+TEST(bitPacking, boolsAndPresenceFlags)
+{
+    FeatureFlags flags;
+    tser::BinaryArchive ba;
+    ba.save(flags);
+    //11 flags in a 2 byte header + 2 bytes for the version
+    ASSERT_EQ(ba.get_buffer().size(), 4u);
+    ASSERT_EQ(ba.load<FeatureFlags>(), flags);
+
+    flags.a = true;
+    flags.j = false;
+    flags.limit = 42;
+    flags.origin = std::make_unique<Point>(Point{ 1, 2 });
+    ba.reset();
+    ba.save(flags);
+    ASSERT_EQ(ba.load<FeatureFlags>(), flags);
+
+    std::vector<bool> bits;
+    for (size_t n = 0; n < 77; ++n)
+        bits.push_back(n % 3 == 0 || n % 7 == 0);
+    ba.reset();
+    ba.save(bits);
+    ASSERT_EQ(ba.get_buffer().size(), 1u + 10u);
+    ASSERT_EQ(ba.load<std::vector<bool>>(), bits);
+}
+
+enum class Status : int32_t { Idle = -2, Running, Paused, Failed, Done };
+template<> struct tser::value_range<Status> { static constexpr Status min = Status::Idle, max = Status::Done; };
+
+struct Telemetry
+{
+    DEFINE_SERIALIZABLE(Telemetry, status, battery, temperature, charging, id)
+    static constexpr bool _packBits = true;
+    Status status = Status::Idle;
+    tser::bounded<uint8_t, 0, 100> battery;
+    tser::bounded<int, -40, 87> temperature;
+    bool charging = false;
+    uint32_t id = 0;
+};
+
+TEST(bitPacking, rangedValues)
+{
+    tser::BinaryArchive ba;
+    //3 + 7 + 7 + 1 bits in a 3 byte header + 1 byte varint
+    ASSERT_EQ(tser::max_serialized_size<Telemetry>(), 3u + 5u);
+    for (int i = 0; i < 50; ++i) {
+        Telemetry t{ static_cast<Status>(i % 5 - 2), static_cast<uint8_t>(i * 2), i * 5 % 128 - 40, i % 2 == 0, static_cast<uint32_t>(i) };
+        ba.reset();
+        ba.save(t);
+        ASSERT_EQ(ba.get_buffer().size(), 4u);
+        ASSERT_EQ(ba.load<Telemetry>(), t);
+    }
+    //outside of bit packed types ranged values use the minimal number of bytes
+    ba.reset();
+    ba.save(Status::Failed);
+    ba.save(tser::bounded<int64_t, -1000, 1000>(-999));
+    ASSERT_EQ(ba.get_buffer().size(), 1u + 2u);
+    ASSERT_EQ(ba.load<Status>(), Status::Failed);
+    ASSERT_EQ((ba.load<tser::bounded<int64_t, -1000, 1000>>()), -999);
+
+    using BoundedStatus = tser::bounded<Status, Status::Running, Status::Failed>;
+    ASSERT_TRUE(BoundedStatus(Status::Running) < BoundedStatus(Status::Failed));
+    ASSERT_LT(tser::sort_key(BoundedStatus(Status::Running)), tser::sort_key(BoundedStatus(Status::Paused)));
+}
+
+struct QuantizedVec3
+{
+    DEFINE_SERIALIZABLE(QuantizedVec3, x, y, z)
+    static constexpr bool _packBits = true;
+    using Coordinate = tser::quantized<float, -1000, 1000, 1000>;
+    Coordinate x, y, z;
+};
+
+TEST(quantization, fixedPoint)
+{
+    tser::BinaryArchive ba;
+    //3 * 21 bits
+    ASSERT_EQ(tser::max_serialized_size<QuantizedVec3>(), 8u);
+    const float values[] = { -1000.f, -999.9995f, -12.3456f, -0.f, 0.0004f, 1.f, 765.4321f, 1000.f };
+    for (float v : values) {
+        ba.reset();
+        ba.save(QuantizedVec3{ v, -v, v / 2 });
+        const auto loaded = ba.load<QuantizedVec3>();
+        ASSERT_NEAR(loaded.x, v, 0.0005f + std::abs(v) * 1e-6f);
+        ASSERT_NEAR(loaded.y, -v, 0.0005f + std::abs(v) * 1e-6f);
+        ASSERT_NEAR(loaded.z, v / 2, 0.0005f + std::abs(v) * 1e-6f);
+    }
+    //out of range values are clamped, standalone values take the minimal number of bytes
+    using Angle = tser::quantized<double, 0, 360, 100>;
+    ba.reset();
+    ba.save(Angle(400.0));
+    ba.save(Angle(-1.0));
+    ba.save(Angle(std::nan("")));
+    ba.save(Angle(123.456));
+    ASSERT_EQ(ba.get_buffer().size(), 4u * 2u);
+    ASSERT_EQ(ba.load<Angle>(), 360.0);
+    ASSERT_EQ(ba.load<Angle>(), 0.0);
+    ASSERT_EQ(ba.load<Angle>(), 0.0);
+    ASSERT_NEAR(ba.load<Angle>(), 123.46, 1e-9);
+}
+
+TEST(xorEncoding, doubleAndFloatSeries)
+{
+    tser::xor_encoded<double> prices;
+    double price = 100.0;
+    for (int i = 0; i < 1000; ++i) {
+        price += (i % 7 == 0) ? 0.25 : 0.0;
+        prices.push_back(price);
+    }
+    prices.insert(prices.end(), { 0.0, -0.0, 1e-310, std::numeric_limits<double>::infinity(), -1e300, 3.141592653589793 });
+    tser::BinaryArchive ba;
+    ba.save(prices);
+    ASSERT_LT(ba.get_buffer().size() * 10, prices.size() * sizeof(double));
+    const auto loaded = ba.load<tser::xor_encoded<double>>();
+    ASSERT_EQ(loaded.size(), prices.size());
+    ASSERT_EQ(std::memcmp(loaded.data(), prices.data(), prices.size() * sizeof(double)), 0);
+    //the encoded payload doesn't go through the string dictionary
+    tser::BinaryArchive dictionary;
+    dictionary.use_string_dictionary();
+    dictionary.save(prices);
+    dictionary.save(prices);
+    for (int i = 0; i < 2; ++i) {
+        const auto fromDictionary = dictionary.load<tser::xor_encoded<double>>();
+        ASSERT_EQ(fromDictionary.size(), prices.size());
+        ASSERT_EQ(std::memcmp(fromDictionary.data(), prices.data(), prices.size() * sizeof(double)), 0);
+    }
+
+    std::vector<float> readings;
+    for (int i = 0; i < 300; ++i)
+        readings.push_back(20.f + static_cast<float>(i % 13) * 0.5f);
+    std::string encoded;
+    tser::encode_xor(readings.data(), readings.size(), encoded);
+    std::vector<float> decoded(readings.size());
+    ASSERT_TRUE(tser::decode_xor(encoded.data(), encoded.size(), decoded.data(), decoded.size()));
+    ASSERT_EQ(decoded, readings);
+    //truncated input
+    ASSERT_FALSE(tser::decode_xor(encoded.data(), encoded.size() / 2, decoded.data(), decoded.size()));
+}
+
+struct LogRecord
+{
+    DEFINE_SERIALIZABLE(LogRecord, level, source, message, tags)
+    std::string level, source, message;
+    std::vector<std::string> tags;
+};
+
+TEST(stringDictionary, repeatedStrings)
+{
+    std::vector<LogRecord> records;
+    const char* levels[] = { "debug", "info", "warning" };
+    for (int i = 0; i < 100; ++i)
+        records.push_back(LogRecord{ levels[i % 3], "network/connection_manager", "message " + std::to_string(i % 10), { "tag" + std::to_string(i % 4), "" } });
+    tser::BinaryArchive plain, interned;
+    interned.use_string_dictionary();
+    plain.save(records);
+    interned.save(records);
+    ASSERT_LT(interned.get_buffer().size() * 5, plain.get_buffer().size());
+
+    tser::BinaryArchive reader(0);
+    reader.use_string_dictionary();
+    reader.initialize(interned.get_buffer());
+    ASSERT_EQ(reader.load<std::vector<LogRecord>>(), records);
+    //the views of repeated strings point to the same dictionary entry in the archive buffer
+    reader.set_read_offset(0);
+    reader.load<size_t>();
+    const auto first = reader.load<std::tuple<std::string_view, std::string_view, std::string_view>>();
+    reader.load<std::vector<std::string>>();
+    reader.load<std::string_view>();
+    const auto source = reader.load<std::string_view>();
+    ASSERT_EQ(std::get<1>(first), "network/connection_manager");
+    ASSERT_EQ(source.data(), std::get<1>(first).data());
+
+    //string_views can be loaded without the dictionary as well
+    plain.set_read_offset(0);
+    plain.load<size_t>();
+    ASSERT_EQ(plain.load<std::string_view>(), "debug");
+}
+
+struct Vertex
+{
+    DEFINE_SERIALIZABLE(Vertex, x, y, z, material, flags)
+    float x = 0, y = 0, z = 0;
+    uint16_t material = 0;
+    int16_t flags = 0;
+};
+struct ReorderedVertex
+{
+    DEFINE_SERIALIZABLE(ReorderedVertex, z, y, x)
+    float x = 0, y = 0, z = 0;
+};
+struct PaddedVertex
+{
+    DEFINE_SERIALIZABLE(PaddedVertex, c, x)
+    char c = 0;
+    float x = 0;
+};
+
+template<typename T>
+std::string memberwiseBytes(const std::vector<T>& values)
+{
+    tser::BinaryArchive ba;
+    ba.save(values.size());
+    for (auto& v : values)
+        std::apply([&](auto& ... mVal) { (ba.save(mVal), ...); }, v.members());
+    return std::string(ba.get_buffer());
+}
+
+TEST(trivialSerialization, wholeStructMemcpy)
+{
+    static_assert(tser::detail::is_trivially_serializable<Vertex>());
+    static_assert(tser::detail::is_trivially_serializable<std::array<Vertex, 2>>());
+    static_assert(tser::detail::is_trivially_serializable<ReorderedVertex>());
+    static_assert(!tser::detail::is_trivially_serializable<PaddedVertex>());
+    static_assert(!tser::detail::is_trivially_serializable<Point>());
+    ASSERT_TRUE(tser::detail::has_contiguous_layout<Vertex>());
+    ASSERT_FALSE(tser::detail::has_contiguous_layout<ReorderedVertex>());
+
+    //the wire format is the same as saving member by member
+    std::vector<Vertex> vertices;
+    std::vector<ReorderedVertex> reordered;
+    std::vector<PaddedVertex> padded;
+    for (int i = 0; i < 100; ++i) {
+        vertices.push_back(Vertex{ i * 0.5f, -i * 1.5f, i * 2.f, static_cast<uint16_t>(i), static_cast<int16_t>(-i) });
+        reordered.push_back(ReorderedVertex{ i * 0.5f, 1.f, -i * 2.f });
+        padded.push_back(PaddedVertex{ static_cast<char>(i), i * 0.25f });
+    }
+    tser::BinaryArchive ba;
+    ba.save(vertices);
+    ASSERT_EQ(ba.get_buffer(), memberwiseBytes(vertices));
+    ba.reset();
+    ba.save(reordered);
+    ASSERT_EQ(ba.get_buffer(), memberwiseBytes(reordered));
+    ba.reset();
+    ba.save(padded);
+    ASSERT_EQ(ba.get_buffer(), memberwiseBytes(padded));
+
+    ba.reset();
+    ba.save(vertices);
+    ba.save(vertices.front());
+    std::vector<Vertex> loaded(1, vertices.back());
+    ba.load(loaded);
+    ASSERT_EQ(loaded.size(), vertices.size() + 1);
+    ASSERT_TRUE(std::equal(vertices.begin(), vertices.end(), loaded.begin() + 1));
+    ASSERT_EQ(ba.load<Vertex>(), vertices.front());
+}
+
+struct Counters
+{
+    DEFINE_SERIALIZABLE(Counters, a, b, c, name)
+    uint64_t a = 0, b = 0, c = 0;
+    std::string name;
+};
+
+struct WideRecord
+{
+    DEFINE_SERIALIZABLE(WideRecord, id, timestamp, position, level, name, count, ratio, state, values)
+    uint64_t id = 0;
+    int64_t timestamp = 0;
+    Vertex position;
+    int16_t level = 0;
+    std::string name;
+    uint32_t count = 0;
+    double ratio = 0;
+    SomeEnum state = SomeEnum::A;
+    std::vector<int> values;
+};
+
+TEST(trivialSerialization, fixedWidthRuns)
+{
+    using Runs = tser::detail::fixed_runs<std::decay_t<decltype(std::declval<WideRecord&>().members())>>;
+    ASSERT_EQ(Runs::sizes[0], 10u + 10u + sizeof(Vertex) + 2u);
+    ASSERT_EQ(Runs::sizes[4], 0u);
+    ASSERT_EQ(Runs::sizes[5], 5u + 8u + sizeof(SomeEnum));
+
+    std::vector<WideRecord> records;
+    for (int i = 0; i < 20; ++i)
+        records.push_back(WideRecord{ static_cast<uint64_t>(i) << (i * 3), -i * 100000LL, Vertex{ 1.f, 2.f, 3.f, 4, 5 }, static_cast<int16_t>(i),
+            std::string(static_cast<size_t>(i), 'n'), static_cast<uint32_t>(i * i), i * 0.5, SomeEnum::C, { i, -i } });
+    tser::BinaryArchive ba;
+    ba.save(records);
+    ASSERT_EQ(ba.get_buffer(), memberwiseBytes(records));
+    ASSERT_EQ(ba.load<std::vector<WideRecord>>(), records);
+
+    //a run that doesn't fit into a StaticArchive is rolled back like any other write
+    tser::StaticArchive<32> small;
+    ASSERT_TRUE(small.save(Vertex{}));
+    ASSERT_FALSE(small.save(records.back()));
+    ASSERT_EQ(small.get_buffer().size(), sizeof(Vertex));
+    //objects that fit are saved even if the worst case size of their run doesn't fit
+    tser::StaticArchive<16> tight;
+    ASSERT_TRUE(tight.save(Counters{ 1, 2, 3, "s" }));
+    ASSERT_EQ(tight.get_buffer().size(), 5u);
+    ASSERT_EQ(tight.load<Counters>(), (Counters{ 1, 2, 3, "s" }));
+}
+
+struct NetworkMessage
+{
+    DEFINE_SERIALIZABLE(NetworkMessage, id, header, flags, vertices, names, lookup, target, optionalFlags)
+    uint64_t id = 0;
+    std::pair<int, std::string> header;
+    FeatureFlags flags;
+    std::vector<Vertex> vertices;
+    std::vector<std::string> names;
+    std::map<int, std::vector<int>> lookup;
+    std::unique_ptr<Point> target;
+    std::optional<Telemetry> optionalFlags;
+    DEFINE_DEEP_POINTER_COMPARISION(NetworkMessage)
+};
+
+TEST(streamDecoder, partialBuffers)
+{
+    std::vector<NetworkMessage> messages(3);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        auto& m = messages[i];
+        m.id = i * 1000000;
+        m.header = { static_cast<int>(i), std::string(i * 100, 'h') };
+        m.flags.limit = static_cast<int>(i);
+        m.vertices.resize(i * 5, Vertex{ 1, 2, 3, 4, 5 });
+        m.names = { "a", std::string(300, 'b') };
+        m.lookup = { { 1, { 1, 2, 3 } }, { -5, {} } };
+        if (i != 1) {
+            m.target = std::make_unique<Point>(Point{ 1, static_cast<int>(i) });
+            m.optionalFlags = Telemetry{ Status::Paused, 50, 20, true, 7 };
+        }
+    }
+    tser::BinaryArchive ba;
+    for (auto& m : messages)
+        ba.save(m);
+    const auto bytes = ba.get_buffer();
+
+    //feed the messages in chunks of every size, including single bytes
+    for (size_t chunk : { size_t(1), size_t(2), size_t(7), size_t(64), bytes.size() }) {
+        tser::StreamDecoder<NetworkMessage> decoder;
+        std::vector<NetworkMessage> decoded;
+        NetworkMessage message;
+        for (size_t offset = 0; offset < bytes.size(); offset += chunk) {
+            decoder.feed(bytes.substr(offset, chunk));
+            while (decoder.next(message))
+                decoded.push_back(std::move(message));
+        }
+        ASSERT_FALSE(decoder.failed());
+        ASSERT_EQ(decoder.buffered(), 0u);
+        ASSERT_EQ(decoded.size(), messages.size());
+        for (size_t i = 0; i < messages.size(); ++i)
+            ASSERT_EQ(decoded[i], messages[i]);
+    }
+
+    //a truncated message never reads past the end, oversized messages fail the decoder
+    tser::StreamDecoder<NetworkMessage> truncated;
+    truncated.feed(bytes.substr(0, 10));
+    NetworkMessage message;
+    ASSERT_FALSE(truncated.next(message));
+    ASSERT_FALSE(truncated.failed());
+    tser::StreamDecoder<NetworkMessage> limited(64);
+    limited.feed(bytes);
+    ASSERT_FALSE(limited.next(message));
+    ASSERT_TRUE(limited.failed());
+
+    //string_views of decoded messages stay valid until the next feed
+    tser::BinaryArchive views;
+    views.save(std::make_pair(1, std::string_view("first")));
+    views.save(std::make_pair(2, std::string_view("second")));
+    tser::StreamDecoder<std::pair<int, std::string_view>> viewDecoder;
+    viewDecoder.feed(views.get_buffer());
+    std::pair<int, std::string_view> first, second;
+    ASSERT_TRUE(viewDecoder.next(first));
+    ASSERT_TRUE(viewDecoder.next(second));
+    ASSERT_EQ(first.second, "first");
+    ASSERT_EQ(second.second, "second");
+    ASSERT_EQ(viewDecoder.buffered(), 0u);
+    //complete messages are decoded in place, only the incomplete tail is copied
+    ASSERT_EQ(first.second.data(), views.get_buffer().data() + views.get_buffer().find("first"));
+    std::string received(views.get_buffer().substr(0, views.get_buffer().size() - 3));
+    viewDecoder.feed(received);
+    ASSERT_TRUE(viewDecoder.next(first));
+    ASSERT_FALSE(viewDecoder.next(second));
+    ASSERT_EQ(viewDecoder.buffered(), received.size() - views.get_buffer().find("second") + 2);
+    const std::string rest(views.get_buffer().substr(received.size()));
+    received.assign(received.size(), 'x');
+    viewDecoder.feed(rest);
+    ASSERT_TRUE(viewDecoder.next(second));
+    ASSERT_EQ(second, std::make_pair(2, std::string_view("second")));
+    ASSERT_EQ(viewDecoder.buffered(), 0u);
+
+    //a size whose byte count would wrap around is malformed instead of waiting for more bytes
+    tser::BinaryArchive wrapping;
+    wrapping.save(std::numeric_limits<uint64_t>::max() / 2);
+    tser::StreamDecoder<std::vector<double>> wrappingDecoder;
+    std::vector<double> doubles;
+    wrappingDecoder.feed(wrapping.get_buffer());
+    ASSERT_FALSE(wrappingDecoder.next(doubles));
+    ASSERT_TRUE(wrappingDecoder.failed());
+}
+
+TEST(archivePool, reuseAndSizeHints)
+{
+    tser::ArchivePool pool;
+    const char* data = nullptr;
+    {
+        auto archive = pool.acquire<LogRecord>();
+        archive->save(std::string(5000, 'x'));
+        data = archive->data();
+    }
+    //the archive comes back reset and with its capacity, sized for the recent LogRecord messages
+    auto archive = pool.acquire<LogRecord>();
+    ASSERT_EQ(archive->data(), data);
+    ASSERT_TRUE(archive->get_buffer().empty());
+    ASSERT_GE(archive->capacity(), 5000u);
+    ASSERT_GE(tser::SizeHint::of<LogRecord>().get(), 5000u);
+
+    //an archive that grew far beyond the typical size is freed instead of pooled
+    {
+        auto huge = pool.acquire();
+        huge->reserve(1 << 20);
+        data = huge->data();
+    }
+    auto next = pool.acquire();
+    ASSERT_NE(next->data(), data);
+    ASSERT_LT(next->capacity(), size_t(1) << 20);
+    next.release();
+
+    //concurrent acquire/release from many threads
+    std::vector<std::thread> threads;
+    std::atomic<size_t> failures{ 0 };
+    for (int t = 0; t < 8; ++t)
+        threads.emplace_back([&pool, &failures, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                auto ba = pool.acquire<Point>();
+                const Point p{ t, i };
+                ba->save(p);
+                failures += ba->load<Point>() == p ? 0u : 1u;
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+    ASSERT_EQ(failures, 0u);
+}
+
+TEST(reload, reusesCapacity)
+{
+    NetworkMessage large, small;
+    large.id = 1;
+    large.header = { 3, std::string(100, 'h') };
+    large.vertices.resize(50);
+    large.names = { std::string(64, 'a'), std::string(64, 'b'), std::string(64, 'c') };
+    large.lookup = { { 1, { 1, 2, 3 } } };
+    large.target = std::make_unique<Point>(Point{ 4, 5 });
+    small.id = 2;
+    small.header = { 4, "short" };
+    small.names = { "x", "y" };
+    small.optionalFlags = Telemetry{ Status::Paused, 50, 20, true, 7 };
+    tser::BinaryArchive ba;
+    ba.save(large);
+    ba.save(small);
+    ba.save(large);
+
+    //load appends to the containers of an existing object, reload overwrites it
+    NetworkMessage scratch;
+    ba.reload(scratch);
+    ASSERT_EQ(scratch, large);
+    const char* name = scratch.names[0].data();
+    const Vertex* vertices = scratch.vertices.data();
+    ba.reload(scratch);
+    ASSERT_EQ(scratch, small);
+    ba.reload(scratch);
+    ASSERT_EQ(scratch, large);
+    ASSERT_EQ(scratch.names[0].data(), name);
+    ASSERT_EQ(scratch.vertices.data(), vertices);
+
+    //the pointee is reused if it is still set
+    const Point* target = scratch.target.get();
+    ba.reset();
+    large.target->x = 42;
+    ba.save(large);
+    ba.reload(scratch);
+    ASSERT_EQ(scratch, large);
+    ASSERT_EQ(scratch.target.get(), target);
+}
+
+struct Shape
+{
+    DEFINE_SERIALIZABLE(Shape, name, geometry)
+    std::string name;
+    std::variant<std::monostate, Point, std::vector<Point>, std::string> geometry;
+};
+
+TEST(variant, alternatives)
+{
+    std::vector<Shape> shapes{ { "empty", {} }, { "point", Point{ 1, 2 } }, { "polygon", std::vector<Point>{ { 0, 0 }, { 1, 0 }, { 0, 1 } } },
+        { "label", std::string("text") } };
+    tser::BinaryArchive ba;
+    ba.save(shapes);
+    ASSERT_EQ(ba.load<std::vector<Shape>>(), shapes);
+    ASSERT_EQ((tser::max_serialized_size<std::variant<int, double>>()), 9u);
+
+    //reloading the same alternative keeps its capacity, a different one is constructed in place
+    Shape scratch{ "", std::vector<Point>(100) };
+    const Point* points = std::get<2>(scratch.geometry).data();
+    ba.reset();
+    ba.save(shapes[2]);
+    ba.save(shapes[1]);
+    ba.reload(scratch);
+    ASSERT_EQ(scratch, shapes[2]);
+    ASSERT_EQ(std::get<2>(scratch.geometry).data(), points);
+    ba.reload(scratch);
+    ASSERT_EQ(scratch, shapes[1]);
+
+    //ordered by the index of the alternative first, consistent with sort_key and hashing
+    ASSERT_TRUE(tser::less(shapes[1].geometry, shapes[2].geometry));
+    ASSERT_TRUE(shapes[3] < shapes[2]);
+    ASSERT_LT(tser::sort_key(shapes[0].geometry), tser::sort_key(shapes[1].geometry));
+    ASSERT_LT(tser::sort_key(Shape{ "a", Point{ 1, 2 } }), tser::sort_key(Shape{ "a", Point{ 1, 3 } }));
+    ASSERT_EQ(tser::hash_value(shapes[1]), tser::hash_value(Shape{ "point", Point{ 1, 2 } }));
+    ASSERT_NE(tser::hash_value(std::variant<int, unsigned>(1)), tser::hash_value(std::variant<int, unsigned>(1u)));
+    std::stringstream ss;
+    ss << shapes[0] << shapes[1];
+    ASSERT_EQ(ss.str(), "{ \"Shape\": {\"name\" : \"empty\", \"geometry\" : null}}\n{ \"Shape\": {\"name\" : \"point\", \"geometry\" : "
+        "{ \"Point\": {\"x\" : 1, \"y\" : 2}}\n}}\n");
+
+    //the stream decoder follows the alternatives as well
+    ba.reset();
+    ba.save(shapes[2]);
+    ba.save(shapes[3]);
+    tser::StreamDecoder<Shape> decoder;
+    Shape decoded;
+    for (size_t i = 0; i < ba.get_buffer().size(); ++i)
+        decoder.feed(ba.get_buffer().substr(i, 1));
+    ASSERT_TRUE(decoder.next(decoded));
+    ASSERT_EQ(decoded, shapes[2]);
+    ASSERT_TRUE(decoder.next(decoded));
+    ASSERT_EQ(decoded, shapes[3]);
+    ASSERT_FALSE(decoder.next(decoded));
+}
+
+struct Sample
+{
+    DEFINE_SERIALIZABLE(Sample, id, hp, position, name, alive)
+    uint64_t id = 0;
+    int16_t hp = 0;
+    Vertex position;
+    std::string name;
+    bool alive = false;
+};
+
+TEST(columnar, columns)
+{
+    tser::columnar<Sample> samples;
+    for (int i = 0; i < 100; ++i)
+        samples.push_back(Sample{ static_cast<uint64_t>(i) * 1000, static_cast<int16_t>(i - 50),
+            Vertex{ i * 0.5f, 1.f, -2.f, static_cast<uint16_t>(i % 3), 0 }, "sample" + std::to_string(i % 7), i % 2 == 0 });
+    tser::BinaryArchive ba;
+    ba.save(samples);
+    ba.save(std::string("after"));
+
+    //loading overwrites the vector
+    tser::columnar<Sample> loaded(3);
+    ba.load(loaded);
+    ASSERT_EQ(loaded, samples);
+    ASSERT_EQ(ba.load<std::string>(), "after");
+
+    //single columns, nested members are addressed by their path
+    std::vector<float> x;
+    std::vector<int16_t> hp;
+    std::vector<std::string> names;
+    std::vector<bool> alive;
+    ba.set_read_offset(0);
+    ASSERT_TRUE(tser::load_column<Sample>(ba, "position.x", x));
+    ASSERT_EQ(ba.load<std::string>(), "after");
+    ba.set_read_offset(0);
+    ASSERT_TRUE(tser::load_column<Sample>(ba, "hp", hp));
+    ba.set_read_offset(0);
+    ASSERT_TRUE(tser::load_column<Sample>(ba, "name", names));
+    ba.set_read_offset(0);
+    ASSERT_TRUE(tser::load_column<Sample>(ba, "alive", alive));
+    ASSERT_EQ(x.size(), samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        ASSERT_EQ(x[i], samples[i].position.x);
+        ASSERT_EQ(hp[i], samples[i].hp);
+        ASSERT_EQ(names[i], samples[i].name);
+        ASSERT_EQ(alive[i], samples[i].alive);
+    }
+    //unknown names and mismatching value types don't read anything
+    ba.set_read_offset(0);
+    ASSERT_FALSE(tser::load_column<Sample>(ba, "position", x));
+    ASSERT_FALSE(tser::load_column<Sample>(ba, "hp", x));
+    ASSERT_EQ(ba.read_offset(), 0u);
+
+    //columns that don't fit leave the bytes written before them alone
+    tser::StaticArchive<20> full;
+    ASSERT_TRUE(full.save(std::string("ab")));
+    ASSERT_FALSE(full.save(samples));
+    ASSERT_EQ(full.get_buffer().size(), 3u);
+    ASSERT_EQ(full.load<std::string>(), "ab");
+}
+
+TEST(recordFile, writeAppendAndLookup)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "tser_record_file_test.bin").string();
+    auto sample = [](int i) {
+        return Sample{ static_cast<uint64_t>(i), static_cast<int16_t>(i % 100), Vertex{ i * 0.5f, 1.f, -2.f, 0, 0 }, "sample" + std::to_string(i), i % 2 == 0 };
+    };
+    auto readFile = [&path]() {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    ASSERT_EQ(tser::RecordWriter().size(), 0u);
+    {
+        //a tiny batch size, so that most records are flushed on their own
+        tser::RecordWriter writer(64);
+        ASSERT_TRUE(writer.open(path));
+        for (int i = 0; i < 1000; ++i)
+            ASSERT_TRUE(writer.append(sample(i), i % 10 == 0 ? "key" + std::to_string(i) : std::string()));
+        ASSERT_TRUE(writer.close());
+    }
+    tser::RecordReader reader(path);
+    ASSERT_TRUE(reader.is_open());
+    ASSERT_EQ(reader.size(), 1000u);
+    Sample s;
+    ASSERT_TRUE(reader.load(999, s));
+    ASSERT_EQ(s, sample(999));
+    ASSERT_EQ(reader.load<Sample>(3), sample(3));
+    ASSERT_TRUE(reader.load("key500", s));
+    ASSERT_EQ(s, sample(500));
+    ASSERT_EQ(reader.key(500), "key500");
+    ASSERT_EQ(reader.key(501), "");
+    ASSERT_EQ(reader.find("key501"), tser::RecordReader::npos);
+    ASSERT_FALSE(reader.load(1000, s));
+    ASSERT_FALSE(reader.load("missing", s));
+    reader.close();
+
+    //appending keeps the existing records and index, a later record with the same key replaces the earlier one
+    const std::string original = readFile();
+    {
+        tser::RecordWriter writer;
+        ASSERT_TRUE(writer.open(path, true));
+        ASSERT_EQ(writer.size(), 1000u);
+        ASSERT_TRUE(writer.append(sample(5000), "key500"));
+    }
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), 1001u);
+    ASSERT_EQ(reader.load<Sample>(0), sample(0));
+    ASSERT_TRUE(reader.load("key500", s));
+    ASSERT_EQ(s, sample(5000));
+    ASSERT_EQ(reader.load<Sample>(500), sample(500));
+    reader.close();
+    ASSERT_EQ(readFile().substr(0, original.size()), original);
+
+    //corrupted records fail to load instead of being decoded
+    ASSERT_TRUE(reader.open(path));
+    //the first record starts at the beginning of the file
+    const auto recordOffset = static_cast<size_t>(reader.record(3).data() - reader.record(0).data());
+    reader.close();
+    std::string corrupted = readFile();
+    corrupted[recordOffset] ^= 1;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << corrupted;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_FALSE(reader.load(3, s));
+    ASSERT_EQ(reader.load<Sample>(4), sample(4));
+    reader.close();
+
+    //files without records and truncated files
+    {
+        tser::RecordWriter writer;
+        ASSERT_TRUE(writer.open(path));
+    }
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), 0u);
+    reader.close();
+    std::filesystem::resize_file(path, 10);
+    ASSERT_FALSE(reader.open(path));
+    tser::RecordWriter writer;
+    ASSERT_FALSE(writer.open(path, true));
+    std::filesystem::remove(path);
+    ASSERT_FALSE(reader.open(path));
+}
+
 TEST(hashing, points)
 {
     std::unordered_set<Point> points;
@@ -314,6 +1124,173 @@ TEST(hashing, points)
     ASSERT_TRUE(true);
 }
 
+TEST(hashing, structural)
+{
+    ComplexType c1(Point{ 1,2 }, Point{ 3, 4 }), c2(Point{ 1,2 }, Point{ 3, 4 });
+    //same elements, but (most likely) a different iteration order
+    c2.sets.clear();
+    c2.sets.rehash(100);
+    c2.sets.insert(Point{ 3,4 });
+    c2.sets.insert(Point{ 1,2 });
+    ASSERT_EQ(c1, c2);
+    ASSERT_EQ(tser::hash<ComplexType>()(c1), tser::hash<ComplexType>()(c2));
+    c2.opt = Point{ 0, 0 };
+    ASSERT_NE(tser::hash<ComplexType>()(c1), tser::hash<ComplexType>()(c2));
+    ASSERT_EQ(tser::hash_value(0.0), tser::hash_value(-0.0));
+    ASSERT_NE(tser::hash_value(std::string("abc")), tser::hash_value(std::string("abd")));
+    ASSERT_NE(tser::hash_value(std::vector<int>{ 1, 2 }), tser::hash_value(std::vector<int>{ 2, 1 }));
+    ASSERT_NE(tser::hash_value(std::make_tuple(std::string("a"), std::string("bc"))), tser::hash_value(std::make_tuple(std::string("ab"), std::string("c"))));
+    ASSERT_EQ(tser::hash_value(CustomPointNoMacro{ 1, 2 }), tser::hash_value(CustomPointNoMacro{ 2, 1 }));
+
+    std::unordered_map<Object, int, tser::hash<Object>> objects;
+    objects[Object{ { 1, 2 }, 3 }] = 1;
+    objects[Object{ { 1, 2 }, 4 }] = 2;
+    ASSERT_EQ(objects.size(), 2u);
+    ASSERT_EQ(objects.at(Object{ { 1, 2 }, 3 }), 1);
+}
+
+struct CachedPoint
+{
+    DEFINE_SERIALIZABLE(CachedPoint, x, y)
+    int x = 0, y = 0;
+    //not part of the value
+    int cache = 0;
+};
+
+TEST(hashing, bytesOfPartialMembers)
+{
+    //equal elements differ in a field members() leaves out, so they can't be hashed by their bytes
+    std::vector<CachedPoint> a{ { 1, 2, 3 } }, b{ { 1, 2, 4 } };
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(tser::hash_value(a), tser::hash_value(b));
+    ASSERT_NE(tser::hash_value(std::vector<Point>{ { 1, 2 } }), tser::hash_value(std::vector<Point>{ { 1, 3 } }));
+}
+
+struct CompositeKey
+{
+    DEFINE_SERIALIZABLE(CompositeKey, name, bytes, point, opt, state)
+    std::string name;
+    std::vector<unsigned char> bytes;
+    Point point;
+    std::optional<int> opt;
+    SomeEnum state = SomeEnum::A;
+};
+
+TEST(compare, threeWay)
+{
+    ASSERT_EQ(tser::compare(Point{ 1, 2 }, Point{ 1, 2 }), 0);
+    ASSERT_EQ(tser::compare(Point{ 1, 2 }, Point{ 1, 3 }), -1);
+    ASSERT_EQ(tser::compare(Point{ 2, 0 }, Point{ 1, 3 }), 1);
+    ASSERT_EQ(tser::compare(std::string("ab"), std::string("abc")), -1);
+    ASSERT_EQ(tser::compare(std::vector<unsigned char>{ 1, 255 }, std::vector<unsigned char>{ 1, 2, 3 }), 1);
+    ASSERT_EQ(tser::compare(std::list<Point>{ { 1, 2 } }, std::list<Point>{ { 1, 2 }, { 0, 0 } }), -1);
+    ASSERT_EQ(tser::compare(std::optional<int>(), std::optional<int>(-5)), -1);
+    //containers without operator< are ordered by size first
+    ASSERT_EQ(tser::compare(std::unordered_set<int>{ 9 }, std::unordered_set<int>{ 1, 2 }), -1);
+
+    std::vector<CompositeKey> keys;
+    for (int i = 0; i < 64; ++i)
+        keys.push_back(CompositeKey{ std::string(1, static_cast<char>('a' + i % 3)), { static_cast<unsigned char>(i % 5) },
+            Point{ i % 2, i % 7 }, i % 4 == 0 ? std::optional<int>() : std::optional<int>(i % 3), static_cast<SomeEnum>(i % 3) });
+    for (auto& lhs : keys)
+        for (auto& rhs : keys) {
+            const bool stdLess = std::tie(lhs.name, lhs.bytes, lhs.point, lhs.opt, lhs.state) < std::tie(rhs.name, rhs.bytes, rhs.point, rhs.opt, rhs.state);
+            ASSERT_EQ(lhs < rhs, stdLess);
+            ASSERT_EQ(tser::less(lhs, rhs), stdLess);
+            ASSERT_EQ(tser::compare(lhs, rhs) == 0, lhs == rhs);
+        }
+}
+
+struct SortRecord
+{
+    DEFINE_SERIALIZABLE(SortRecord, key, value, weight, tags)
+    CompositeKey key;
+    int64_t value = 0;
+    double weight = 0;
+    std::vector<std::string> tags;
+};
+
+TEST(sortKey, matchesCompare)
+{
+    std::vector<SortRecord> records;
+    const double weights[] = { -1e300, -2.5, -0.0, 0.0, 1e-300, 3.25, 1e300 };
+    for (int i = 0; i < 200; ++i) {
+        SortRecord r;
+        r.key = CompositeKey{ std::string(static_cast<size_t>(i % 3), static_cast<char>(i % 2 ? 'a' : '\0')), { static_cast<unsigned char>(i % 5 * 60) },
+            Point{ i % 2 - 1, i % 7 - 3 }, i % 4 == 0 ? std::optional<int>() : std::optional<int>(i % 3 - 1), static_cast<SomeEnum>(i % 3) };
+        r.value = (i % 11 - 5) * 1000000007LL;
+        r.weight = weights[i % 7];
+        r.tags.resize(static_cast<size_t>(i % 3), std::string(1, static_cast<char>('x' + i % 2)));
+        records.push_back(r);
+    }
+    for (auto& lhs : records)
+        for (auto& rhs : records) {
+            const int keyOrder = tser::sort_key(lhs).compare(tser::sort_key(rhs));
+            ASSERT_EQ((keyOrder > 0) - (keyOrder < 0), tser::compare(lhs, rhs));
+        }
+}
+
+struct ReplicatedState
+{
+    DEFINE_SERIALIZABLE(ReplicatedState, tick, complex, players, scores, target)
+    uint64_t tick = 0;
+    ComplexType complex{ Point{ 1, 2 }, Point{ 3, 4 } };
+    std::vector<Point> players;
+    std::map<std::string, std::vector<int>> scores;
+    std::unique_ptr<Point> target;
+    DEFINE_DEEP_POINTER_COMPARISION(ReplicatedState)
+};
+
+TEST(patch, diffAndApply)
+{
+    ReplicatedState oldState;
+    oldState.players = { { 1, 1 }, { 2, 2 }, { 3, 3 } };
+    oldState.scores = { { "a", { 1 } }, { "b", { 2, 3 } }, { "c", {} } };
+    oldState.target = std::make_unique<Point>(Point{ 5, 5 });
+    ReplicatedState newState;
+    tser::apply_patch(newState, tser::diff(newState, oldState));
+    ASSERT_EQ(newState, oldState);
+    //unchanged objects only cost the terminator
+    ASSERT_EQ(tser::diff(oldState, newState), std::string(1, '\0'));
+
+    newState.tick = 1;
+    newState.complex.x2.y = 10;
+    newState.complex.intArray[2] = Point{ 7, 7 };
+    newState.complex.mapping['c'] = 'd';
+    newState.complex.mapping.erase('a');
+    newState.complex.opt = Point{ 8, 8 };
+    newState.players[1].x = 20;
+    newState.players.push_back({ 4, 4 });
+    newState.scores["b"].push_back(4);
+    newState.scores.erase("c");
+    newState.scores["d"] = { 5 };
+    newState.target->y = 6;
+    const auto patch = tser::diff(oldState, newState);
+    tser::apply_patch(oldState, patch);
+    ASSERT_EQ(oldState, newState);
+
+    //a single changed member costs a few bytes instead of the whole object
+    newState.players[2].y = 30;
+    tser::BinaryArchive ba;
+    ba.save(newState);
+    ASSERT_LT(tser::diff(oldState, newState).size() * 4, ba.get_buffer().size());
+    tser::apply_patch(oldState, tser::diff(oldState, newState));
+    ASSERT_EQ(oldState, newState);
+
+    //shrinking containers and resetting pointers
+    newState.players.resize(1);
+    newState.target.reset();
+    tser::apply_patch(oldState, tser::diff(oldState, newState));
+    ASSERT_EQ(oldState, newState);
+
+    //values that are stored whole are reloaded in place, so raw pointees are reused instead of leaked
+    Point pointee{ 1, 1 }, changedPointee{ 2, 2 };
+    std::pair<int, Point*> oldPair{ 1, &pointee }, newPair{ 1, &changedPointee };
+    tser::apply_patch(oldPair, tser::diff(oldPair, newPair));
+    ASSERT_EQ(oldPair.second, &pointee);
+    ASSERT_EQ(pointee, changedPointee);
+}
+
 TEST(VLE, unsigned_encode_decode_up_to_513)
 {
     std::string somebuffer(10, '\0');
@@ -423,3 +1400,170 @@ TEST(print_diff, basic_test)
     tser::print_diff(a,b, std::cout);
 
 }
+
+TEST(compression, archiveRoundTrip)
+{
+    tser::BinaryArchive ba;
+    std::vector<std::string> names(500, "Monster");
+    for (size_t i = 0; i < names.size(); ++i)
+        names[i] += std::to_string(i % 7);
+    ba << names << ComplexType(Point{ 1,2 }, Point{ 3, 4 });
+    auto compressed = tser::compress(ba);
+    ASSERT_LT(compressed.size(), ba.get_buffer().size() / 4);
+    tser::BinaryArchive loaded(0);
+    ASSERT_TRUE(tser::decompress(compressed, loaded));
+    ASSERT_EQ(loaded.get_buffer(), ba.get_buffer());
+    ASSERT_EQ(loaded.load<decltype(names)>(), names);
+    //empty payloads decompress into archives without storage
+    tser::BinaryArchive empty(0);
+    ASSERT_TRUE(tser::decompress(tser::compress(tser::BinaryArchive(0)), empty));
+    ASSERT_TRUE(empty.get_buffer().empty());
+}
+
+TEST(compression, blocksAndIncompressibleData)
+{
+    std::string input(300000, '\0');
+    unsigned state = 12345;
+    for (size_t i = 0; i < input.size(); ++i) {
+        state = state * 1103515245u + 12345u;
+        //the first half is random, the second half is highly repetitive
+        input[i] = i < input.size() / 2 ? static_cast<char>(state >> 16) : static_cast<char>('a' + i % 13);
+    }
+    for (size_t blockSize : { size_t(1), size_t(100), size_t(4096), tser::g_lzBlockSize }) {
+        std::string decompressed;
+        ASSERT_TRUE(tser::decompress_lz(tser::compress_lz(input, blockSize), decompressed));
+        ASSERT_EQ(decompressed, input);
+    }
+    std::string empty;
+    ASSERT_TRUE(tser::decompress_lz(tser::compress_lz(""), empty));
+    ASSERT_TRUE(empty.empty());
+}
+
+TEST(compression, malformedInput)
+{
+    auto compressed = tser::compress_lz(std::string(1000, 'x'));
+    std::string out;
+    ASSERT_FALSE(tser::decompress_lz(std::string_view(compressed).substr(0, compressed.size() - 1), out));
+    //a raw size that doesn't match the decoded block (1001 instead of 1000)
+    ASSERT_EQ(compressed[0], '\xe8');
+    compressed[0] = '\xe9';
+    out.clear();
+    ASSERT_FALSE(tser::decompress_lz(compressed, out));
+
+    //hand written blocks: varint raw size, varint compressed size, token (literal length << 4 | match length - 4), literals, match offset
+    auto block = [](size_t rawSize, std::string_view payload) {
+        return std::string{ static_cast<char>(rawSize), static_cast<char>(payload.size()) }.append(payload);
+    };
+    out.clear();
+    ASSERT_TRUE(tser::decompress_lz(block(5, std::string_view("\x10" "a\x01\x00", 4)), out));
+    ASSERT_EQ(out, "aaaaa");
+    //the match starts in front of the output
+    ASSERT_FALSE(tser::decompress_lz(block(5, std::string_view("\x10" "a\x05\x00", 4)), out));
+    ASSERT_FALSE(tser::decompress_lz(block(5, std::string_view("\x10" "a\x00\x00", 4)), out));
+    //literals longer than the block or than the remaining input
+    ASSERT_FALSE(tser::decompress_lz(block(3, "\x50" "abcde"), out));
+    ASSERT_FALSE(tser::decompress_lz(block(5, "\x50" "ab"), out));
+    ASSERT_FALSE(tser::decompress_lz(block(20, "\xf0\xff\xff" "ab"), out));
+}
+
+TEST(checksum, crc32c)
+{
+    ASSERT_EQ(tser::crc32c("123456789"), 0xE3069283u);
+    ASSERT_EQ(tser::crc32c(""), 0u);
+    std::string data(1001, '\0');
+    std::iota(data.begin(), data.end(), '\0');
+    ASSERT_EQ(tser::crc32c(data), ~tser::detail::crc32c_scalar(~0u, data.data(), data.size()));
+    ASSERT_EQ(tser::crc32c(std::string_view(data).substr(13), tser::crc32c(std::string_view(data).substr(0, 13))), tser::crc32c(data));
+    //compare against a bytewise reference for all lengths and alignments around the 8 byte steps
+    auto reference = [](std::string_view str) { uint32_t crc = ~0u;
+        for (char c : str) { crc ^= static_cast<uint8_t>(c); for (int k = 0; k < 8; ++k) crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1; }
+        return ~crc; };
+    for (size_t offset = 0; offset < 8; ++offset)
+        for (size_t size = 0; size < 40; ++size) {
+            const auto part = std::string_view(data).substr(offset, size);
+            ASSERT_EQ(tser::crc32c(part), reference(part));
+            ASSERT_EQ(~tser::detail::crc32c_scalar(~0u, part.data(), part.size()), reference(part));
+        }
+}
+
+TEST(checksum, checkedFrames)
+{
+    tser::BinaryArchive ba;
+    tser::save_checked(ba, ComplexType(Point{ 1,2 }, Point{ 3, 4 }));
+    tser::save_checked(ba, std::string("Hello World!"));
+    ComplexType c;
+    c.ints.clear();
+    c.sets.clear();
+    std::string str;
+    ASSERT_TRUE(tser::load_checked(ba, c));
+    ASSERT_TRUE(tser::load_checked(ba, str));
+    ASSERT_EQ(c, ComplexType(Point{ 1,2 }, Point{ 3, 4 }));
+    ASSERT_EQ(str, "Hello World!");
+    ASSERT_FALSE(tser::load_checked(ba, str));
+
+    tser::BinaryArchive corrupted(0);
+    std::string bytes(ba.get_buffer());
+    bytes[bytes.size() - 6] ^= 1;
+    corrupted.initialize(bytes);
+    ASSERT_TRUE(tser::load_checked(corrupted, c));
+    ASSERT_FALSE(tser::load_checked(corrupted, str));
+    corrupted.initialize(bytes.substr(0, 5));
+    ASSERT_FALSE(tser::load_checked(corrupted, c));
+
+    //frames that don't fit fail without touching the bytes written before them
+    tser::StaticArchive<16> full;
+    full.save(std::array<char, 2>{ 'a', 'b' });
+    ASSERT_FALSE(tser::save_checked(full, std::string(20, 'x')));
+    ASSERT_EQ(full.get_buffer().substr(0, 2), "ab");
+    tser::StaticArchive<3> tiny;
+    tiny.save(std::array<char, 2>{ 'a', 'b' });
+    ASSERT_FALSE(tser::save_checked(tiny, 'c'));
+    ASSERT_EQ(tiny.get_buffer(), "ab");
+    ASSERT_TRUE(tser::save_checked(ba, 'c'));
+}
+
+TEST(checksum, checkedFramesWithSeveralBlocks)
+{
+    std::vector<std::string> strings(2000);
+    for (size_t i = 0; i < strings.size(); ++i)
+        strings[i] = "string number " + std::to_string(i);
+    tser::BinaryArchive ba;
+    tser::save_checked(ba, strings);
+    tser::save_checked(ba, std::string());
+    std::vector<std::string> loaded;
+    std::string empty;
+    ASSERT_TRUE(tser::load_checked(ba, loaded));
+    ASSERT_TRUE(tser::load_checked(ba, empty));
+    ASSERT_EQ(loaded, strings);
+    ASSERT_EQ(ba.read_offset(), ba.get_buffer().size());
+    //the payload spans three blocks, corrupting the middle one stops decoding at the block boundary
+    std::string bytes(ba.get_buffer());
+    bytes[20000] ^= 1;
+    tser::BinaryArchive corrupted(0);
+    corrupted.initialize(bytes);
+    loaded.clear();
+    ASSERT_FALSE(tser::load_checked(corrupted, loaded));
+    ASSERT_EQ(corrupted.read_offset(), 0u);
+    ASSERT_TRUE(loaded.back().empty());
+    ASSERT_TRUE(std::equal(loaded.begin(), loaded.begin() + 500, strings.begin()));
+}
+
+TEST(checksum, checkedBitVectors)
+{
+    std::vector<bool> bits(200000);
+    for (size_t i = 0; i < bits.size(); i += 3)
+        bits[i] = true;
+    tser::BinaryArchive ba;
+    tser::save_checked(ba, bits);
+    std::vector<bool> loaded;
+    ASSERT_TRUE(tser::load_checked(ba, loaded));
+    ASSERT_EQ(loaded, bits);
+    //the packed bits span two blocks, the corrupted second one is detected before it is unpacked
+    std::string bytes(ba.get_buffer());
+    bytes[20000] ^= 1;
+    tser::BinaryArchive corrupted;
+    corrupted.initialize(bytes);
+    loaded.clear();
+    ASSERT_FALSE(tser::load_checked(corrupted, loaded));
+    ASSERT_TRUE(loaded.empty());
+}
@@ -0,0 +1,127 @@
+// Licensed under the Boost License <https://opensource.org/licenses/BSL-1.0>.
+// SPDX-License-Identifier: BSL-1.0
+//the statistics change the layout of BinaryArchive, so they are tested in their own executable
+#define TSER_ENABLE_STATS
+#include "gtest/gtest.h"
+#include "tser/tser.hpp"
+
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <vector>
+
+//counts the heap allocations of the process, so the statistics can be compared with the real number of allocations
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+static size_t g_allocations = 0;
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+struct Item
+{
+    DEFINE_SERIALIZABLE(Item, id, name)
+    int id = 0;
+    std::string name;
+};
+
+struct Inventory
+{
+    DEFINE_SERIALIZABLE(Inventory, items, ids, owner)
+    std::vector<Item> items;
+    std::list<int> ids;
+    std::unique_ptr<Item> owner;
+};
+
+TEST(stats, growth)
+{
+    tser::BinaryArchive ba(8);
+    ASSERT_EQ(ba.stats().resizes, 1u);
+    ba.save(std::string(100, 'x'));
+    const auto& stats = ba.stats();
+    ASSERT_GT(stats.resizes, 0u);
+    ASSERT_GT(stats.bytesCopied, 0u);
+    ASSERT_GE(ba.capacity(), 101u);
+    ASSERT_EQ(stats.bytesWritten, ba.get_buffer().size());
+    ba.reset_stats();
+    ASSERT_EQ(ba.stats().resizes, 0u);
+}
+
+TEST(stats, perTypeBytesAndAllocations)
+{
+    Inventory inventory;
+    inventory.items = { Item{ 1, "sword" }, Item{ 2, "shield" } };
+    inventory.ids = { 1, 2, 3 };
+    inventory.owner = std::make_unique<Item>(Item{ 3, "owner" });
+    tser::BinaryArchive ba;
+    ba.save(inventory);
+    const auto& stats = ba.stats();
+    ASSERT_EQ(stats.types.at("Inventory").bytesWritten, ba.get_buffer().size());
+    ASSERT_EQ(stats.types.at("Inventory").saved, 1u);
+    ASSERT_EQ(stats.types.at("Item").saved, 3u);
+
+    const size_t allocations = g_allocations;
+    auto loaded = ba.load<Inventory>();
+    ASSERT_EQ(stats.loadAllocations, g_allocations - allocations);
+    ASSERT_EQ(stats.bytesRead, ba.get_buffer().size());
+    ASSERT_EQ(stats.types.at("Inventory").bytesRead, ba.get_buffer().size());
+    ASSERT_EQ(stats.types.at("Item").loaded, 3u);
+    //3 list nodes, the owner and at least one allocation for the vector of items
+    ASSERT_GE(stats.loadAllocations, 5u);
+}
+
+TEST(stats, loadAllocationsOfStrings)
+{
+    const std::vector<std::string> strings = { "short", std::string(100, 'x'), "", std::string(1000, 'y') };
+    const std::string longString(50, 'z');
+    tser::BinaryArchive ba;
+    ba.save(strings);
+    ba.save(longString);
+    const size_t allocations = g_allocations;
+    auto loadedStrings = ba.load<std::vector<std::string>>();
+    auto loadedString = ba.load<std::string>();
+    ASSERT_EQ(ba.stats().loadAllocations, g_allocations - allocations);
+    ASSERT_EQ(loadedStrings, strings);
+    ASSERT_EQ(loadedString, longString);
+    //the vector, the two strings inside it and the string longer than the small string buffer allocate at least once
+    ASSERT_GE(ba.stats().loadAllocations, 4u);
+}
+
+TEST(stats, perMemberReport)
+{
+    Inventory inventory;
+    inventory.items = { Item{ 1, "sword" }, Item{ 2, std::string(100, 's') } };
+    inventory.ids = { 1, 2, 3 };
+    tser::BinaryArchive ba;
+    ba.enable_stats_timing();
+    ba.save(inventory);
+    auto& stats = ba.stats();
+    auto& members = stats.types.at("Inventory").members;
+    ASSERT_EQ(members.at("items").bytesWritten + members.at("ids").bytesWritten + members.at("owner").bytesWritten, ba.get_buffer().size());
+    ASSERT_EQ(members.at("owner").bytesWritten, 1u);
+    ASSERT_GT(stats.types.at("Item").members.at("name").bytesWritten, 100u);
+    ASSERT_GT(stats.types.at("Inventory").saveNanoseconds, 0u);
+
+    ba.load<Inventory>();
+    ASSERT_EQ(members.at("items").bytesRead, members.at("items").bytesWritten);
+
+    std::stringstream text, json;
+    tser::print_stats(text, stats);
+    tser::print_stats_json(json, stats);
+    //members are sorted by their size in the text report
+    ASSERT_LT(text.str().find("  items:"), text.str().find("  ids:"));
+    ASSERT_NE(json.str().find("\"Item\": {\"bytesWritten\": "), std::string::npos);
+    ASSERT_NE(json.str().find("\"owner\": {\"bytesWritten\": 1, \"bytesRead\": 1"), std::string::npos);
+}